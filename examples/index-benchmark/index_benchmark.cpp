@@ -0,0 +1,245 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+/**
+ * @file
+ *
+ * This example measures the spatial indexes of EZGL on objects that move every frame: how many objects can be updated
+ * per second, and how long a query for the visible world takes afterwards. It then compares the query time of a scene
+ * and a tile grid on a static array of tiles, and times nearest snap point searches.
+ *
+ * Usage: index-benchmark [number of objects] [number of frames]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ezgl/quadtree.hpp"
+#include "ezgl/scene.hpp"
+#include "ezgl/snap_registry.hpp"
+#include "ezgl/tile_grid.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+// The world, and the size of the objects and of the view within it
+static ezgl::rectangle const world = {{0, 0}, {10000, 10000}};
+static double const max_object_size = 20;
+static double const view_size = 500;
+
+struct moving_object {
+  ezgl::rectangle bounds;
+  double vx, vy;
+};
+
+static double seconds_since(clock_type::time_point start)
+{
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// Move every object by its velocity, bouncing off the edges of the world
+static void step(std::vector<moving_object> &objects)
+{
+  for(moving_object &o : objects) {
+    if(o.bounds.left() + o.vx < world.left() || o.bounds.right() + o.vx > world.right())
+      o.vx = -o.vx;
+    if(o.bounds.bottom() + o.vy < world.bottom() || o.bounds.top() + o.vy > world.top())
+      o.vy = -o.vy;
+
+    o.bounds += {o.vx, o.vy};
+  }
+}
+
+static void report(const char *name, double update_seconds, double query_seconds, std::size_t updates, int queries)
+{
+  std::cout << name << ": " << updates / update_seconds / 1e6 << " M updates/s, " << query_seconds / queries * 1e6
+            << " us/query" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::size_t num_objects = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  int num_frames = argc > 2 ? std::atoi(argv[2]) : 100;
+  int const queries_per_frame = 10;
+
+  std::mt19937 random(42);
+  std::uniform_real_distribution<double> position(world.left(), world.right() - max_object_size);
+  std::uniform_real_distribution<double> size(1, max_object_size);
+  std::uniform_real_distribution<double> velocity(-5, 5);
+  std::uniform_real_distribution<double> view_position(world.left(), world.right() - view_size);
+
+  std::vector<moving_object> objects(num_objects);
+  for(moving_object &o : objects) {
+    ezgl::point2d origin = {position(random), position(random)};
+    o.bounds = {origin, size(random), size(random)};
+    o.vx = velocity(random);
+    o.vy = velocity(random);
+  }
+
+  std::vector<ezgl::rectangle> views;
+  for(int i = 0; i < num_frames * queries_per_frame; ++i) {
+    ezgl::point2d origin = {view_position(random), view_position(random)};
+    views.push_back({origin, view_size, view_size});
+  }
+
+  std::cout << num_objects << " objects, " << num_frames << " frames" << std::endl;
+
+  // The loose quadtree moves each object in place
+  {
+    std::vector<moving_object> state = objects;
+    ezgl::loose_quadtree index(world);
+    std::vector<ezgl::quadtree_handle> handles;
+
+    auto start = clock_type::now();
+    for(std::size_t i = 0; i < state.size(); ++i)
+      handles.push_back(index.insert(state[i].bounds, static_cast<ezgl::primitive_id>(i + 1)));
+    std::cout << "loose_quadtree insert: " << state.size() / seconds_since(start) / 1e6 << " M inserts/s" << std::endl;
+
+    double update_seconds = 0, query_seconds = 0;
+    std::size_t found = 0;
+    for(int frame = 0; frame < num_frames; ++frame) {
+      step(state);
+
+      start = clock_type::now();
+      for(std::size_t i = 0; i < state.size(); ++i)
+        index.move(handles[i], state[i].bounds);
+      update_seconds += seconds_since(start);
+
+      start = clock_type::now();
+      for(int q = 0; q < queries_per_frame; ++q)
+        index.query(views[frame * queries_per_frame + q],
+            [&](ezgl::quadtree_handle, ezgl::rectangle const &, ezgl::primitive_id) { ++found; });
+      query_seconds += seconds_since(start);
+    }
+    report("loose_quadtree move", update_seconds, query_seconds, state.size() * num_frames,
+        num_frames * queries_per_frame);
+
+    start = clock_type::now();
+    for(ezgl::quadtree_handle handle : handles)
+      index.remove(handle);
+    std::cout << "loose_quadtree remove: " << handles.size() / seconds_since(start) / 1e6 << " M removes/s" << std::endl;
+    std::cout << "  (" << found << " objects found)" << std::endl;
+  }
+
+  // The scene rebuilds its packed R-tree whenever anything changes
+  {
+    std::vector<moving_object> state = objects;
+    ezgl::scene index;
+
+    double update_seconds = 0, query_seconds = 0;
+    std::size_t found = 0;
+    for(int frame = 0; frame < num_frames; ++frame) {
+      step(state);
+
+      auto start = clock_type::now();
+      index.clear();
+      std::uint32_t style = index.add_style(ezgl::BLACK);
+      for(std::size_t i = 0; i < state.size(); ++i)
+        index.add_fill_rectangle(state[i].bounds, style, static_cast<ezgl::primitive_id>(i + 1));
+      index.build();
+      update_seconds += seconds_since(start);
+
+      start = clock_type::now();
+      for(int q = 0; q < queries_per_frame; ++q)
+        index.query(views[frame * queries_per_frame + q], [&](ezgl::scene_primitive const &) { ++found; });
+      query_seconds += seconds_since(start);
+    }
+    report("scene rebuild", update_seconds, query_seconds, state.size() * num_frames,
+        num_frames * queries_per_frame);
+    std::cout << "  (" << found << " objects found)" << std::endl;
+  }
+
+  // A static array of tiles with two primitives each, the size of the world
+  {
+    int const tiles_per_side = static_cast<int>(std::sqrt(num_objects / 2.0)) + 1;
+    double const tile_size = world.width() / tiles_per_side;
+
+    ezgl::scene tree;
+    ezgl::tile_grid grid(world.bottom_left(), tile_size, tile_size, tiles_per_side, tiles_per_side);
+    std::uint32_t tree_style = tree.add_style(ezgl::BLACK);
+    std::uint32_t grid_style = grid.add_style(ezgl::BLACK);
+
+    for(int row = 0; row < tiles_per_side; ++row) {
+      for(int column = 0; column < tiles_per_side; ++column) {
+        ezgl::rectangle tile = grid.tile_bounds(column, row);
+        ezgl::point2d corner = {tile.left() + 0.1 * tile_size, tile.bottom() + 0.1 * tile_size};
+        ezgl::rectangle block = {corner, 0.5 * tile_size, 0.5 * tile_size};
+        auto id = static_cast<ezgl::primitive_id>(row * tiles_per_side + column + 1);
+
+        tree.add_fill_rectangle(block, tree_style, id);
+        tree.add_line(tile.bottom_left(), tile.top_right(), tree_style, id);
+        grid.add_fill_rectangle(column, row, block, grid_style, id);
+        grid.add_line(column, row, tile.bottom_left(), tile.top_right(), grid_style, id);
+      }
+    }
+
+    auto start = clock_type::now();
+    tree.build();
+    double tree_build = seconds_since(start);
+
+    start = clock_type::now();
+    grid.build();
+    double grid_build = seconds_since(start);
+
+    std::size_t tree_found = 0, grid_found = 0;
+
+    start = clock_type::now();
+    for(ezgl::rectangle const &view : views)
+      tree.query(view, [&](ezgl::scene_primitive const &) { ++tree_found; });
+    double tree_query = seconds_since(start);
+
+    start = clock_type::now();
+    for(ezgl::rectangle const &view : views)
+      grid.query(view, [&](ezgl::scene_primitive const &) { ++grid_found; });
+    double grid_query = seconds_since(start);
+
+    std::cout << tiles_per_side << "x" << tiles_per_side << " tiles" << std::endl;
+    std::cout << "scene: " << tree_build * 1e3 << " ms build, " << tree_query / views.size() * 1e6 << " us/query ("
+              << tree_found << " found)" << std::endl;
+    std::cout << "tile_grid: " << grid_build * 1e3 << " ms build, " << grid_query / views.size() * 1e6
+              << " us/query (" << grid_found << " found)" << std::endl;
+  }
+
+  // Snapping the cursor to the nearest of many points
+  {
+    ezgl::snap_registry points;
+    points.reserve(num_objects);
+    for(std::size_t i = 0; i < num_objects; ++i)
+      points.add({position(random), position(random)}, static_cast<ezgl::primitive_id>(i + 1));
+
+    auto start = clock_type::now();
+    points.build();
+    double build_seconds = seconds_since(start);
+
+    std::size_t snapped = 0;
+    start = clock_type::now();
+    for(ezgl::rectangle const &view : views) {
+      if(points.nearest(view.center(), max_object_size) != nullptr)
+        ++snapped;
+    }
+    double search_seconds = seconds_since(start);
+
+    std::cout << "snap_registry: " << build_seconds * 1e3 << " ms build, " << search_seconds / views.size() * 1e6
+              << " us/search (" << snapped << " snapped)" << std::endl;
+  }
+
+  return 0;
+}
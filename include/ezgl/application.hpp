@@ -21,6 +21,7 @@
 #define EZGL_APPLICATION_HPP
 #define ECE297
 
+#include "ezgl/cache.hpp"
 #include "ezgl/canvas.hpp"
 #include "ezgl/control.hpp"
 #include "ezgl/callback.hpp"
@@ -71,6 +72,13 @@ using button_callback_fn = void (*)(GtkWidget *widget, application *app);
  */
 using mouse_callback_fn = void (*)(application *app, GdkEventButton *event, double x, double y);
 
+/**
+ * The signature of a user-defined callback function for rubber-band selection
+ *
+ * @see application::set_box_select_callback
+ */
+using box_select_callback_fn = void (*)(application *app, rectangle const &world, std::vector<primitive_id> const &ids);
+
 /**
  * The signature of a user-defined callback function for keyboard events
  */
@@ -451,6 +459,30 @@ public:
    */
   void flush_drawing();
 
+  /**
+   * Get the manager that enforces the memory budget shared by all ezgl caches (tiles, glyphs, images, ...).
+   *
+   * Caches created by ezgl register with this manager. Application code can register its own caches
+   * (see ezgl::lru_cache) with it so they share the same budget.
+   */
+  cache_manager &get_cache_manager();
+
+  /**
+   * Change the maximum number of bytes all ezgl caches may hold together.
+   *
+   * Caches are trimmed immediately if they currently hold more than the new budget.
+   *
+   * @param bytes The new budget, in bytes.
+   */
+  void set_cache_budget(std::size_t bytes);
+
+  /**
+   * Get the memory usage, hit rate and eviction count of every ezgl cache.
+   *
+   * Useful for monitoring long-running sessions; e.g., periodically report the result with update_message().
+   */
+  cache_manager_stats get_cache_stats() const;
+
   /**
    * Run the application.
    *
@@ -532,6 +564,20 @@ public:
     return m_window_id;
   }
 
+  /**
+   * Enable rubber-band selection on the main canvas.
+   *
+   * Dragging with the panning mouse button while holding Shift draws a selection box instead of panning. When the
+   * button is released, the objects in the box (see canvas::select) are passed to the callback. A Shift+click that
+   * moves the pointer by only a few pixels is still passed to the mouse press callback.
+   *
+   * @param box_select_user_callback The function to call with the selected objects, or nullptr to disable selection.
+   */
+  void set_box_select_callback(box_select_callback_fn box_select_user_callback)
+  {
+    box_select_callback = box_select_user_callback;
+  }
+
   /**
    * Get the ID of the main canvas 
    */
@@ -601,6 +647,9 @@ public:
 
   // The user-defined callback function for handling keyboard press
   key_callback_fn key_press_callback;
+
+  // The user-defined callback function for rubber-band selection
+  box_select_callback_fn box_select_callback = nullptr;
 };
 
 /**
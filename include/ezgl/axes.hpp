@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_AXES_HPP
+#define EZGL_AXES_HPP
+
+#include "ezgl/cache.hpp"
+#include "ezgl/color.hpp"
+#include "ezgl/graphics.hpp"
+
+#include <cairo.h>
+
+#include <string>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * Draws a grid and tick labels for the visible world of a plot, at round numbers chosen from the zoom level.
+ *
+ * Drawing labels with draw_text measures and shapes the text every frame. The labels are instead rendered once into
+ * small surfaces, cached by their text (see cache_manager), and copied to the screen; panning mostly reuses the same
+ * labels. The grid lines are drawn as a single batch (see renderer::draw_lines).
+ */
+class axes {
+public:
+  /**
+   * Create axes with a light grey grid and black labels.
+   */
+  axes();
+
+  /**
+   * Set the color of the grid lines.
+   */
+  void set_grid_color(color c);
+
+  /**
+   * Set the color of the labels.
+   */
+  void set_label_color(color c);
+
+  /**
+   * Set the font size of the labels.
+   */
+  void set_font_size(double size);
+
+  /**
+   * Set the smallest distance between grid lines, in pixels.
+   */
+  void set_tick_spacing(double pixels);
+
+  /**
+   * Draw the grid over the renderer's visible world, with labels along the bottom and left edges.
+   *
+   * @param g The renderer to draw with. Its coordinate system, color, line width and justification are changed.
+   */
+  void draw(renderer *g);
+
+  /**
+   * Compute the distance between ticks: 1, 2 or 5 times a power of 10, giving at most a number of ticks in a range.
+   *
+   * @param range The length of the range.
+   * @param max_ticks The largest number of ticks.
+   */
+  static double tick_step(double range, double max_ticks);
+
+private:
+  // Get the surface of a label, rendering it if it is not cached
+  cairo_surface_t *label(std::string const &text);
+
+  // Format the value of a tick with as many decimals as the step needs
+  static std::string format_tick(double value, double step);
+
+  color m_grid_color;
+  color m_label_color;
+  double m_font_size = 10;
+  double m_tick_spacing = 80;
+
+  // The rendered labels, by text
+  lru_cache<std::string, cairo_surface_t *> m_labels;
+
+  // Reused between draws to pass the grid lines to the renderer
+  std::vector<line_segment> m_grid;
+};
+}
+
+#endif //EZGL_AXES_HPP
@@ -0,0 +1,569 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_CACHE_HPP
+#define EZGL_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * The default byte budget shared by all caches registered with a cache_manager (256 MiB).
+ */
+constexpr std::size_t DEFAULT_CACHE_BUDGET = std::size_t(256) << 20;
+
+/**
+ * How a cache chooses which entries to drop when it has to free memory.
+ */
+enum class eviction_policy {
+  /**
+   * Evict the least recently used entry first.
+   */
+  lru,
+
+  /**
+   * Segmented LRU: new entries are placed in a probation segment and only move to a protected segment when they are
+   * used a second time. Entries that were used once (e.g., while panning across a large scene) are evicted before
+   * entries that are used repeatedly, so a single scan cannot flush the whole cache.
+   */
+  segmented_lru
+};
+
+/**
+ * A snapshot of the memory usage and hit rate of a single cache.
+ */
+struct cache_stats {
+  /**
+   * The name the cache was registered with.
+   */
+  std::string name;
+
+  /**
+   * The number of bytes currently held by the cache.
+   */
+  std::size_t bytes = 0;
+
+  /**
+   * The number of entries currently held by the cache.
+   */
+  std::size_t entries = 0;
+
+  /**
+   * The relative share of the global budget the cache is entitled to.
+   */
+  double weight = 1.0;
+
+  /**
+   * The number of lookups that found an entry.
+   */
+  std::uint64_t hits = 0;
+
+  /**
+   * The number of lookups that did not find an entry.
+   */
+  std::uint64_t misses = 0;
+
+  /**
+   * The number of entries dropped to stay within the budget.
+   */
+  std::uint64_t evictions = 0;
+};
+
+/**
+ * A snapshot of the memory usage of every cache registered with a cache_manager.
+ */
+struct cache_manager_stats {
+  /**
+   * The global byte budget.
+   */
+  std::size_t budget = 0;
+
+  /**
+   * The total number of bytes held by all caches.
+   */
+  std::size_t bytes = 0;
+
+  /**
+   * The total number of cache hits.
+   */
+  std::uint64_t hits = 0;
+
+  /**
+   * The total number of cache misses.
+   */
+  std::uint64_t misses = 0;
+
+  /**
+   * The total number of evictions.
+   */
+  std::uint64_t evictions = 0;
+
+  /**
+   * The statistics of each registered cache.
+   */
+  std::vector<cache_stats> caches;
+};
+
+class cache_manager;
+
+/**
+ * The part of a cache that the cache_manager needs to see: its size, its weight and a way to make it smaller.
+ *
+ * Caches register themselves with a cache_manager on construction and unregister on destruction. Caches are not
+ * thread-safe and must only be used from the thread running the GTK event loop.
+ */
+class cache_base {
+public:
+  /**
+   * Destructor. Unregisters the cache from its manager.
+   */
+  virtual ~cache_base();
+
+  /**
+   * Copies are disabled.
+   */
+  cache_base(cache_base const &) = delete;
+
+  /**
+   * Copies are disabled.
+   */
+  cache_base &operator=(cache_base const &) = delete;
+
+  /**
+   * The name of the cache, used in statistics.
+   */
+  std::string const &name() const
+  {
+    return m_name;
+  }
+
+  /**
+   * The number of bytes held by the cache.
+   */
+  std::size_t bytes() const
+  {
+    return m_bytes;
+  }
+
+  /**
+   * The relative share of the global budget this cache is entitled to.
+   */
+  double weight() const
+  {
+    return m_weight;
+  }
+
+  /**
+   * Change the relative share of the global budget this cache is entitled to.
+   *
+   * @param new_weight A positive weight. A cache with weight 2 may hold twice as many bytes as a cache with weight 1
+   *                   before it is chosen for eviction.
+   */
+  void set_weight(double new_weight);
+
+  /**
+   * The number of entries held by the cache.
+   */
+  virtual std::size_t size() const = 0;
+
+  /**
+   * Drop entries until at least bytes_to_free bytes have been released or only the most recent entry is left.
+   *
+   * @return The number of bytes released.
+   */
+  virtual std::size_t evict(std::size_t bytes_to_free) = 0;
+
+  /**
+   * Drop all entries.
+   */
+  virtual void clear() = 0;
+
+  /**
+   * Get a snapshot of the memory usage and hit rate of this cache.
+   */
+  cache_stats stats() const;
+
+protected:
+  /**
+   * Create a cache and register it with a manager.
+   *
+   * @param name The name of the cache, used in statistics.
+   * @param weight The relative share of the global budget this cache is entitled to.
+   * @param manager The manager to register with, or nullptr for an unmanaged cache.
+   */
+  cache_base(std::string name, double weight, cache_manager *manager);
+
+  /**
+   * Account for bytes added to the cache. The manager may evict entries from any cache (including this one) before
+   * this function returns.
+   */
+  void charge(std::size_t added_bytes);
+
+  /**
+   * Account for bytes removed from the cache.
+   */
+  void release(std::size_t removed_bytes, bool evicted);
+
+  // Lookup counters
+  std::uint64_t m_hits = 0;
+  std::uint64_t m_misses = 0;
+  std::uint64_t m_evictions = 0;
+
+private:
+  friend class cache_manager;
+
+  // The name of the cache
+  std::string m_name;
+
+  // The relative share of the global budget
+  double m_weight;
+
+  // The number of bytes held by the cache
+  std::size_t m_bytes = 0;
+
+  // A non-owning pointer to the manager this cache is registered with
+  cache_manager *m_manager;
+};
+
+/**
+ * Enforces a global byte budget across all ezgl caches (tiles, glyphs, images, display lists, ...).
+ *
+ * When the caches together grow beyond the budget, the manager evicts from the cache that exceeds its weighted share
+ * of the budget by the largest amount, until the total fits in the budget again.
+ */
+class cache_manager {
+public:
+  /**
+   * Create a manager.
+   *
+   * @param budget The maximum number of bytes all registered caches may hold together.
+   */
+  explicit cache_manager(std::size_t budget = DEFAULT_CACHE_BUDGET);
+
+  /**
+   * Destructor. Caches that are still registered become unmanaged.
+   */
+  ~cache_manager();
+
+  /**
+   * Copies are disabled.
+   */
+  cache_manager(cache_manager const &) = delete;
+
+  /**
+   * Copies are disabled.
+   */
+  cache_manager &operator=(cache_manager const &) = delete;
+
+  /**
+   * Change the global byte budget. Caches are trimmed immediately if they exceed the new budget.
+   */
+  void set_budget(std::size_t new_budget);
+
+  /**
+   * Get the global byte budget.
+   */
+  std::size_t get_budget() const
+  {
+    return m_budget;
+  }
+
+  /**
+   * The number of bytes held by all registered caches.
+   */
+  std::size_t bytes() const
+  {
+    return m_bytes;
+  }
+
+  /**
+   * Evict entries until the registered caches fit in the budget.
+   */
+  void trim();
+
+  /**
+   * Drop all entries of all registered caches.
+   */
+  void clear();
+
+  /**
+   * Get a snapshot of the memory usage of all registered caches.
+   */
+  cache_manager_stats stats() const;
+
+private:
+  friend class cache_base;
+
+  // Register/unregister a cache
+  void attach(cache_base *cache);
+  void detach(cache_base *cache);
+
+  // The registered caches (non-owning)
+  std::vector<cache_base *> m_caches;
+
+  // The global byte budget
+  std::size_t m_budget;
+
+  // The number of bytes held by all registered caches
+  std::size_t m_bytes = 0;
+
+  // Guards against re-entering trim() while a cache is evicting
+  bool m_trimming = false;
+};
+
+/**
+ * The manager used by all caches created inside ezgl.
+ *
+ * @see application::get_cache_manager
+ */
+cache_manager &default_cache_manager();
+
+/**
+ * A key-value cache with a byte size per entry, registered with a cache_manager.
+ *
+ * Pointers returned by find() and insert() remain valid until the next call to insert(), evict() or clear() on any
+ * cache registered with the same manager.
+ *
+ * @tparam Key The type of the key. Must be hashable with Hash.
+ * @tparam Value The cached type. Resources it owns must be released by its destructor (or by the on_evict function).
+ * @tparam Hash The hash function for keys.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class lru_cache : public cache_base {
+public:
+  /**
+   * A function called on a value right before it is dropped from the cache.
+   */
+  using evict_fn = std::function<void(Value &)>;
+
+  /**
+   * Create a cache.
+   *
+   * @param name The name of the cache, used in statistics.
+   * @param weight The relative share of the global budget this cache is entitled to.
+   * @param policy How entries are chosen for eviction.
+   * @param manager The manager to register with, or nullptr for an unmanaged cache.
+   * @param on_evict (optional) A function to release the resources held by a value.
+   */
+  lru_cache(std::string name,
+      double weight = 1.0,
+      eviction_policy policy = eviction_policy::lru,
+      cache_manager *manager = &default_cache_manager(),
+      evict_fn on_evict = nullptr)
+      : cache_base(std::move(name), weight, manager), m_policy(policy), m_on_evict(std::move(on_evict))
+  {
+  }
+
+  /**
+   * Destructor.
+   */
+  ~lru_cache() override
+  {
+    clear();
+  }
+
+  /**
+   * Look up a value and mark it as recently used.
+   *
+   * @return A pointer to the value, or nullptr if the key is not cached.
+   */
+  Value *find(Key const &key)
+  {
+    auto it = m_index.find(key);
+    if(it == m_index.end()) {
+      ++m_misses;
+      return nullptr;
+    }
+
+    ++m_hits;
+    touch(it->second);
+
+    return &it->second->value;
+  }
+
+  /**
+   * Insert (or replace) a value.
+   *
+   * @param key The key of the value.
+   * @param value The value to cache.
+   * @param value_bytes The memory held by the value, in bytes.
+   *
+   * @return A pointer to the cached value.
+   */
+  Value *insert(Key const &key, Value value, std::size_t value_bytes)
+  {
+    erase(key);
+
+    m_probation.push_front(entry{key, std::move(value), value_bytes, false});
+    auto it = m_probation.begin();
+    m_index.emplace(key, it);
+
+    // The newest entry is never evicted, so the pointer stays valid through charge()
+    charge(value_bytes);
+
+    return &it->value;
+  }
+
+  /**
+   * Test if a key is cached, without marking it as recently used or counting a hit or miss.
+   */
+  bool contains(Key const &key) const
+  {
+    return m_index.find(key) != m_index.end();
+  }
+
+  /**
+   * Remove a value from the cache.
+   *
+   * @return true if the key was cached.
+   */
+  bool erase(Key const &key)
+  {
+    auto it = m_index.find(key);
+    if(it == m_index.end())
+      return false;
+
+    auto entry_it = it->second;
+    m_index.erase(it);
+    drop(entry_it, false);
+
+    return true;
+  }
+
+  std::size_t size() const override
+  {
+    return m_index.size();
+  }
+
+  std::size_t evict(std::size_t bytes_to_free) override
+  {
+    std::size_t freed = 0;
+
+    while(freed < bytes_to_free) {
+      // Probation entries go first; the front of probation is the newest entry and is never evicted
+      std::list<entry> *victims = nullptr;
+      if(m_probation.size() > 1)
+        victims = &m_probation;
+      else if(!m_protected.empty())
+        victims = &m_protected;
+      else
+        break;
+
+      auto victim = std::prev(victims->end());
+      freed += victim->bytes;
+      m_index.erase(victim->key);
+      drop(victim, true);
+    }
+
+    return freed;
+  }
+
+  void clear() override
+  {
+    while(!m_probation.empty()) {
+      m_index.erase(m_probation.front().key);
+      drop(m_probation.begin(), false);
+    }
+
+    while(!m_protected.empty()) {
+      m_index.erase(m_protected.front().key);
+      drop(m_protected.begin(), false);
+    }
+  }
+
+private:
+  struct entry {
+    Key key;
+    Value value;
+    std::size_t bytes;
+    bool is_protected;
+  };
+
+  using entry_iterator = typename std::list<entry>::iterator;
+
+  // Mark an entry as most recently used
+  void touch(entry_iterator it)
+  {
+    if(m_policy == eviction_policy::lru || it->is_protected) {
+      std::list<entry> &segment = it->is_protected ? m_protected : m_probation;
+      segment.splice(segment.begin(), segment, it);
+      return;
+    }
+
+    // Second use: promote from probation to protected
+    it->is_protected = true;
+    m_protected_bytes += it->bytes;
+    m_protected.splice(m_protected.begin(), m_probation, it);
+
+    // Keep the protected segment at most 80% of the cache; demote its LRU entries back to probation
+    while(m_protected.size() > 1 && m_protected_bytes * 5 > bytes() * 4) {
+      auto demoted = std::prev(m_protected.end());
+      demoted->is_protected = false;
+      m_protected_bytes -= demoted->bytes;
+      auto position = m_probation.empty() ? m_probation.begin() : std::next(m_probation.begin());
+      m_probation.splice(position, m_protected, demoted);
+    }
+  }
+
+  // Remove an entry from its segment (the caller has already removed it from the index)
+  void drop(entry_iterator it, bool evicted)
+  {
+    std::size_t entry_bytes = it->bytes;
+
+    if(m_on_evict)
+      m_on_evict(it->value);
+
+    if(it->is_protected) {
+      m_protected_bytes -= entry_bytes;
+      m_protected.erase(it);
+    } else {
+      m_probation.erase(it);
+    }
+
+    release(entry_bytes, evicted);
+  }
+
+  // How entries are chosen for eviction
+  eviction_policy m_policy;
+
+  // Called before a value is dropped
+  evict_fn m_on_evict;
+
+  // Entries used once (or all entries for plain LRU), most recent first
+  std::list<entry> m_probation;
+
+  // Entries used more than once (segmented LRU only), most recent first
+  std::list<entry> m_protected;
+
+  // The number of bytes in the protected segment
+  std::size_t m_protected_bytes = 0;
+
+  // Key lookup
+  std::unordered_map<Key, entry_iterator, Hash> m_index;
+};
+}
+
+#endif //EZGL_CACHE_HPP
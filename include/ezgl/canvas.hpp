@@ -23,13 +23,19 @@
 #include "ezgl/rectangle.hpp"
 #include "ezgl/graphics.hpp"
 #include "ezgl/color.hpp"
+#include "ezgl/quadtree.hpp"
+#include "ezgl/scene.hpp"
+#include "ezgl/snap_registry.hpp"
 
 #include <cairo.h>
 #include <cairo-pdf.h>
 #include <cairo-svg.h>
 #include <gtk/gtk.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace ezgl {
 
@@ -99,6 +105,222 @@ public:
     return m_camera;
   }
 
+  /**
+   * Get the retained scene of this canvas.
+   *
+   * The scene is drawn (culled to the visible world) each time the canvas is redrawn, before the draw callback is
+   * called, so the draw callback only has to draw what is not part of the scene.
+   */
+  scene &get_scene()
+  {
+    return m_scene;
+  }
+
+  /**
+   * Get the index of the moving objects of this canvas.
+   *
+   * Objects that change every frame (e.g., animated or dragged items drawn by the draw callback) do not belong in the
+   * scene, whose index is rebuilt when it changes. Register their bounding boxes here instead and move them as they
+   * change; the draw callback can then cull them with get_dynamic_index().query(g->get_visible_world(), ...), and
+   * pick() finds them.
+   */
+  loose_quadtree &get_dynamic_index()
+  {
+    return m_dynamic_index;
+  }
+
+  /**
+   * Find the object at a point: the smallest object of the dynamic index whose bounding box contains it, or else the
+   * topmost tagged primitive of the scene.
+   *
+   * @param world The point, in world coordinates (see camera::widget_to_world).
+   * @param tolerance_pixels How far, in pixels, the point may be from an object.
+   *
+   * @return The id of the object, or 0 if there is none.
+   */
+  primitive_id pick(point2d world, double tolerance_pixels = 3);
+
+  /**
+   * Get the points the cursor can snap to on this canvas (e.g., pins).
+   */
+  snap_registry &get_snap_points()
+  {
+    return m_snap_points;
+  }
+
+  /**
+   * Find the snap point nearest to a position, e.g., in a mouse move callback.
+   *
+   * @param world The position, in world coordinates.
+   * @param max_dist The largest distance to snap from, in world coordinates.
+   *
+   * @return The nearest snap point, or nullptr if there is none within max_dist.
+   */
+  snap_point const *nearest(point2d world, double max_dist)
+  {
+    return m_snap_points.nearest(world, max_dist);
+  }
+
+  /**
+   * Highlight some primitives of the scene (e.g., the object under the mouse).
+   *
+   * The highlighted primitives are drawn again in the given style on a transparent overlay that is composited over the
+   * canvas when the widget is repainted, so changing the highlight does not redraw the canvas: its cost depends only
+   * on the number of highlighted primitives. The highlight is kept when the canvas is redrawn.
+   *
+   * @param ids The ids of the primitives to highlight (see scene::draw_highlight).
+   * @param style The color and line width of the highlight.
+   */
+  void set_highlight(std::vector<primitive_id> const &ids, scene_style style);
+
+  /**
+   * Remove the highlight set by set_highlight.
+   */
+  void clear_highlight();
+
+  /**
+   * Keep a hidden ID buffer of the scene, for exact hover and click lookups on arbitrary shapes.
+   *
+   * The ID buffer holds, for each pixel, the tagged scene primitive drawn on top there (see scene::draw_ids). It is
+   * not rendered with every frame: id_at re-renders what changed since the last lookup, which is everything after the
+   * view changes, or only the regions passed to invalidate_ids after the scene is edited.
+   *
+   * @param enabled true to keep an ID buffer, false to free it.
+   */
+  void set_id_buffer_enabled(bool enabled);
+
+  /**
+   * Find the tagged scene primitive drawn at a pixel by reading the ID buffer.
+   *
+   * Unlike pick(), this is exact for diagonal lines and polygons, and it costs a single read once the buffer is up to
+   * date. The ID buffer must be enabled (see set_id_buffer_enabled).
+   *
+   * @param widget The pixel, in widget coordinates (e.g., the position of a mouse event).
+   *
+   * @return The id of the primitive, or 0 if there is none or the backend is render_backend::null.
+   */
+  primitive_id id_at(point2d widget);
+
+  /**
+   * Mark a region of the scene as edited, so that the ID buffer re-renders it before the next lookup.
+   *
+   * @param world_region The region that changed, in world coordinates.
+   */
+  void invalidate_ids(rectangle const &world_region);
+
+  /**
+   * Mark the whole ID buffer as out of date.
+   */
+  void invalidate_ids();
+
+  /**
+   * Draw the scene through a style index buffer, so that changing its colors does not render it again.
+   *
+   * The index buffer holds, for each pixel, the style of the scene primitive drawn on top there (see
+   * scene::draw_style_indices). Each redraw maps it to colors through the scene's palette, a lookup per pixel, and only
+   * renders it again after the view changes or invalidate_indices is called. Switching color schemes is then a matter
+   * of calling scene::set_style_color and redraw. The scene is drawn without antialiasing, and translucent colors are
+   * blended with the background but not with each other.
+   *
+   * @param enabled true to draw the scene through an index buffer, false to draw it directly and free the buffer.
+   */
+  void set_indexed_rendering(bool enabled);
+
+  /**
+   * Mark the style index buffer as out of date, after primitives are added to the scene or its styles are reassigned.
+   * Color changes made with scene::set_style_color do not need this.
+   */
+  void invalidate_indices();
+
+  /**
+   * Find the objects in a region: the objects of the dynamic index and the tagged primitives of the scene whose
+   * bounding boxes intersect it.
+   *
+   * @param world_region The region, in world coordinates.
+   *
+   * @return The ids of the objects, sorted and without duplicates. Untagged objects (id 0) are not included.
+   */
+  std::vector<primitive_id> select(rectangle const &world_region);
+
+  /**
+   * Show a rubber band rectangle on top of the canvas (e.g., while the user drags a selection box).
+   *
+   * The rectangle is drawn over the last rendered frame when the widget is repainted, so moving it does not redraw
+   * the canvas.
+   *
+   * @param widget_box The rectangle, in widget coordinates.
+   */
+  void set_selection_box(rectangle const &widget_box);
+
+  /**
+   * Hide the rubber band rectangle shown by set_selection_box.
+   */
+  void clear_selection_box();
+
+  /**
+   * Save the retained scene of this canvas to a binary scene file.
+   *
+   * @param file_name name of the output file
+   * @return true if the file was written
+   */
+  bool save_scene(const char *file_name);
+
+  /**
+   * Replace the retained scene of this canvas with a scene file written by save_scene().
+   *
+   * The file is memory-mapped rather than parsed, so loading is nearly instant regardless of its size.
+   * Call redraw() to show the new scene.
+   *
+   * @param file_name name of the scene file
+   * @param paged keep the scene on disk and page in only what is drawn (see scene::load_paged), for scenes larger
+   *              than memory
+   * @return true if the file was loaded
+   */
+  bool load_scene(const char *file_name, bool paged = false);
+
+  /**
+   * Replace the retained scene of this canvas with a scene file that is read in the background.
+   *
+   * The canvas is usable immediately: pages of the file are read on a separate thread, visible pages first, and the
+   * canvas is redrawn as pages covering the visible world arrive. With a memory budget only the pages needed for the
+   * visible world are kept in memory, so files larger than memory can be browsed.
+   *
+   * @param file_name name of the scene file
+   * @param memory_budget bytes of primitives to keep in memory, or 0 to read the whole file
+   * @return true if the stream was started
+   */
+  bool stream_scene(const char *file_name, std::size_t memory_budget = 0);
+
+  /**
+   * Draw frames in time slices, so a slow draw callback does not keep the user interface from responding.
+   *
+   * Each call of the draw callback gets a deadline, which renderer::out_of_time reports. A callback that stops early
+   * calls renderer::suspend and returns: the canvas shows the partial frame, returns to the event loop, and calls the
+   * callback again when the application is idle, with renderer::get_resume_point telling it where to continue. When
+   * the view changes, the rest of the frame is discarded and a new frame is started. Callbacks that never suspend
+   * draw each frame in one call, as without time slices.
+   *
+   * @param milliseconds The length of a slice, or 0 for no deadline.
+   */
+  void set_time_slice(int milliseconds);
+
+  /**
+   * Change how the canvas renders its frames, and redraw it.
+   *
+   * The backend is initially given by the EZGL_BACKEND environment variable (see render_backend_from_environment).
+   *
+   * @param backend The new backend.
+   */
+  void set_render_backend(render_backend backend);
+
+  /**
+   * Get the backend the canvas renders its frames with.
+   */
+  render_backend get_render_backend() const
+  {
+    return m_backend;
+  }
+
   /**
    * Create an animation renderer that can be used to draw on top of the current canvas
    */
@@ -150,6 +372,21 @@ private:
   // A non-owning pointer to the drawing area inside a GTK window.
   GtkWidget *m_drawing_area = nullptr;
 
+  // How frames are rendered; it decides the kind of m_surface
+  render_backend m_backend = render_backend_from_environment();
+
+  // The length of a time slice in milliseconds (0 if frames are not time-sliced)
+  int m_time_slice = 0;
+
+  // Counts the frames started by redraw; slices of an older frame are dropped
+  std::uint64_t m_frame = 0;
+
+  // The frame being drawn in slices: where its next slice starts, the view it is drawn for, and the idle source that
+  // draws the next slice (0 if the frame is complete)
+  std::size_t m_resume_point = 0;
+  rectangle m_slice_world;
+  guint m_slice_source = 0;
+
   // The off-screen surface that can be drawn to.
   cairo_surface_t *m_surface = nullptr;
 
@@ -159,7 +396,80 @@ private:
   // The animation renderer
   renderer *m_animation_renderer = nullptr;
 
+  // The retained primitives drawn before the draw callback
+  scene m_scene;
+
+  // The moving objects, indexed separately from the scene
+  loose_quadtree m_dynamic_index;
+
+  // The points the cursor can snap to
+  snap_registry m_snap_points;
+
+  // The highlighted primitives and their style
+  std::vector<primitive_id> m_highlight_ids;
+  scene_style m_highlight_style = {};
+
+  // The overlay the highlight is drawn on, and the pixels it covers (if m_highlight_drawn)
+  cairo_surface_t *m_highlight_surface = nullptr;
+  rectangle m_highlight_extent;
+  bool m_highlight_drawn = false;
+
+  // The ID buffer: the slot of the tagged primitive at each pixel (see scene::draw_ids), and the id of each slot
+  bool m_id_buffer_enabled = false;
+  cairo_surface_t *m_id_surface = nullptr;
+  std::vector<primitive_id> m_id_slots;
+
+  // The visible world the ID buffer was rendered for, and whether it must be rendered again entirely
+  rectangle m_id_world;
+  bool m_id_stale = true;
+
+  // The regions of the world to render again in the ID buffer
+  std::vector<rectangle> m_id_dirty;
+
+  // Indexed rendering: the 1 + palette index of the style at each pixel (see scene::draw_style_indices), and the
+  // colors it maps to through the palette
+  bool m_indexed_rendering = false;
+  cairo_surface_t *m_index_surface = nullptr;
+  cairo_surface_t *m_indexed_color_surface = nullptr;
+  std::vector<std::uint32_t> m_palette;
+
+  // The visible world the index buffer was rendered for, and whether it must be rendered again
+  rectangle m_index_world;
+  bool m_index_stale = true;
+
+  // The rubber band rectangle drawn over the canvas, in widget coordinates
+  rectangle m_selection_box;
+  bool m_show_selection_box = false;
+
+  // The GLib source that polls a streaming scene (0 when the scene is not streaming)
+  guint m_stream_source = 0;
+
 private:
+  // Draw the retained scene to a cairo context
+  void draw_scene(cairo_t *context, camera *cam, cairo_surface_t *p_surface);
+
+  // Draw a slice of the frame: the background and the scene if it is the first, then the draw callback. Returns false
+  // if the callback suspended the frame.
+  bool draw_frame_slice(bool first);
+
+  // Draw the next slice of the frame when the application is idle
+  static gboolean continue_frame(gpointer self);
+
+  // Draw the scene by mapping the style index buffer through the palette, rendering the buffer first if it is stale
+  void draw_indexed_scene(cairo_t *frame);
+
+  // Draw the highlight on its overlay, erasing the previous one (or the whole overlay, after the view changed)
+  void draw_highlight(bool view_changed);
+
+  // Bring the ID buffer up to date with the view and the edited regions
+  void update_id_buffer();
+
+  // Repaint the part of the widget covered by a rubber band rectangle
+  void queue_draw_selection_box();
+
+  // Periodically make pages of a streaming scene visible, redrawing if they are on screen
+  static gboolean update_scene_stream(gpointer self);
+
   // Called each time our drawing area widget has changed (e.g., in size).
   static gboolean configure_event(GtkWidget *widget, GdkEventConfigure *event, gpointer data);
 
@@ -23,6 +23,7 @@
 #include "ezgl/point.hpp"
 #include "ezgl/rectangle.hpp"
 #include "ezgl/camera.hpp"
+#include "ezgl/path.hpp"
 
 #include <cairo.h>
 #include <gdk/gdk.h>
@@ -41,8 +42,10 @@
 #include <string>
 #include <vector>
 #include <cfloat>
+#include <cstddef>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 
 namespace ezgl {
 
@@ -161,6 +164,143 @@ enum class line_dash : int {
   asymmetric_5_3
 };
 
+/**
+ * How renderer::draw_graph draws edges shorter than a pixel.
+ */
+enum class short_edges : int {
+  /**
+   * Draw them like the other edges.
+   */
+  draw,
+
+  /**
+   * Draw them at a quarter of the current color's opacity, so dense clusters of tiny edges do not look solid.
+   */
+  fade,
+
+  /**
+   * Do not draw them.
+   */
+  drop
+};
+
+/**
+ * How a canvas renders its frames. The backend can be chosen when the program starts with the EZGL_BACKEND
+ * environment variable (see render_backend_from_environment) or changed with canvas::set_render_backend, so the same
+ * program can compare them.
+ */
+enum class render_backend : int {
+  /**
+   * Draw opaque primitives with X11 requests and the others with cairo, on a surface of the X server. Without X11
+   * support, this is the same as cairo.
+   */
+  x11,
+
+  /**
+   * Draw everything with cairo, on a surface of the window system.
+   */
+  cairo,
+
+  /**
+   * Draw everything with cairo, on an image surface in memory.
+   */
+  cairo_image,
+
+  /**
+   * Record the frame's drawing commands with cairo, then replay them on a surface of the window system. The cost of
+   * issuing the commands is then separate from the cost of rendering them in a profile.
+   */
+  recording,
+
+  /**
+   * Draw nothing: only the draw callback runs, on an empty surface that clips every primitive away. The retained
+   * scene, the highlight overlay and the ID buffer are skipped, so a frame costs only the callback and the renderer's
+   * own work.
+   */
+  null
+};
+
+/**
+ * Get the backend named by the EZGL_BACKEND environment variable: one of x11, cairo, image, recording or null.
+ *
+ * @return The backend, or x11 (cairo_image without X11 support) if the variable is not set or not recognized.
+ */
+render_backend render_backend_from_environment();
+
+/**
+ * A line segment, for drawing many lines at once (see renderer::draw_lines).
+ */
+struct line_segment {
+  /**
+   * The start of the segment.
+   */
+  point2d start;
+
+  /**
+   * The end of the segment.
+   */
+  point2d end;
+};
+
+/**
+ * A read-only view of elements spaced a fixed number of bytes apart, for drawing geometry stored inside a user's own
+ * structs in place (see the range overloads of renderer::draw_lines).
+ *
+ * For example, strided_view<line_segment>(&wires[0].shape, wires.size(), sizeof(wire)) views the shape member of
+ * every element of a std::vector<wire> without copying it.
+ */
+template <typename T>
+class strided_view {
+public:
+  /**
+   * Create a view.
+   *
+   * @param first The first element.
+   * @param count The number of elements.
+   * @param stride The distance between consecutive elements, in bytes.
+   */
+  strided_view(T const *first, std::size_t count, std::size_t stride = sizeof(T))
+      : m_first(reinterpret_cast<unsigned char const *>(first)), m_count(count), m_stride(stride)
+  {
+  }
+
+  /**
+   * The number of elements.
+   */
+  std::size_t size() const
+  {
+    return m_count;
+  }
+
+  /**
+   * The i-th element.
+   */
+  T const &operator[](std::size_t i) const
+  {
+    return *reinterpret_cast<T const *>(m_first + i * m_stride);
+  }
+
+private:
+  unsigned char const *m_first;
+  std::size_t m_count;
+  std::size_t m_stride;
+};
+
+/**
+ * The default projection of the range overloads of renderer::draw_lines, fill_rectangles and draw_arrows: the
+ * elements of the range are used as they are.
+ */
+struct identity_projection {
+  template <typename T>
+  T const &operator()(T const &item) const
+  {
+    return item;
+  }
+};
+
+template <t_coordinate_system System>
+class coordinate_view;
+
 /**
  * Provides functions to draw primitives (e.g., lines, shapes) to a rendering context (the MainCanvas).
  *
@@ -205,6 +345,36 @@ public:
    */
   rectangle get_visible_screen();
 
+  /**
+   * Test if the draw callback should stop drawing and return: the canvas draws its frames in time slices (see
+   * canvas::set_time_slice) and the current slice is over, or the canvas has started a newer frame (e.g., the user
+   * panned while the callback let GTK handle events).
+   *
+   * A callback that stops before it has drawn everything calls suspend so the canvas calls it again to finish the
+   * frame. Reading the clock takes tens of nanoseconds, so poll every few hundred primitives rather than for each one.
+   */
+  bool out_of_time() const;
+
+  /**
+   * Leave the rest of the frame for later: after the draw callback returns, the canvas shows what was drawn and calls
+   * the callback again in a later slice, on top of it, with get_resume_point() returning resume_point. The frame is
+   * discarded instead if the view changes in the meantime.
+   *
+   * The colors, line widths and other settings of the renderer are not kept between slices.
+   *
+   * @param resume_point Where to continue drawing (e.g., the index of the next object), with a meaning chosen by the
+   *                     callback.
+   */
+  void suspend(std::size_t resume_point);
+
+  /**
+   * Where to continue drawing: 0 at the start of a frame, or the value given to suspend in the previous slice.
+   */
+  std::size_t get_resume_point() const
+  {
+    return m_resume_point;
+  }
+
   /**
    * Get the screen coordinates (pixel locations) of the world coordinate rectangle box
    * 
@@ -372,6 +542,116 @@ public:
    */
   void fill_rectangle(rectangle r);
 
+  /**
+   * Draw many line segments in the current color and line width.
+   *
+   * This is faster than calling draw_line for each segment: off-screen segments are skipped, and the others are sent
+   * to X11 in one request or stroked by cairo as a single path.
+   *
+   * @param segments The segments, in the current coordinate system (world or screen).
+   */
+  void draw_lines(std::vector<line_segment> const &segments);
+
+  /**
+   * Draw many line segments, each in its own color, with the current line width.
+   *
+   * The segments are grouped by color and each group is drawn as by draw_lines, so segments of different colors are
+   * not drawn in the order given. The current color is not changed.
+   *
+   * @param segments The segments, in the current coordinate system (world or screen).
+   * @param colors The color of each segment.
+   */
+  void draw_lines(std::vector<line_segment> const &segments, std::vector<packed_color> const &colors);
+
+  /**
+   * Draw many filled rectangles in the current color.
+   *
+   * This is faster than calling fill_rectangle for each rectangle: off-screen rectangles are skipped, and the others
+   * are sent to X11 in one request or filled by cairo as a single path. With a translucent color, overlapping
+   * rectangles are blended once.
+   *
+   * @param rects The rectangles, in the current coordinate system (world or screen).
+   */
+  void fill_rectangles(std::vector<rectangle> const &rects);
+
+  /**
+   * Draw many filled rectangles, each in its own color.
+   *
+   * The rectangles are grouped by color and each group is drawn as by fill_rectangles, so rectangles of different
+   * colors are not drawn in the order given. The current color is not changed.
+   *
+   * @param rects The rectangles, in the current coordinate system (world or screen).
+   * @param colors The color of each rectangle.
+   */
+  void fill_rectangles(std::vector<rectangle> const &rects, std::vector<packed_color> const &colors);
+
+  /**
+   * Draw many arrows in the current color and line width: each segment with a filled triangular head at its end.
+   *
+   * The heads are computed in pixels, all into one buffer; the shafts are drawn as one batch of lines (see draw_lines)
+   * and the heads as one fill with cairo, or a run of polygon requests with X11, instead of a draw_line and a fill_poly
+   * per arrow.
+   *
+   * @param segments The arrows, from their tail to their head, in the current coordinate system (world or screen).
+   * @param head_size The length of the heads, in pixels. A head is half as wide as it is long.
+   */
+  void draw_arrows(std::vector<line_segment> const &segments, double head_size);
+
+  /**
+   * Draw many line segments read in place from any container, without copying them into a std::vector first.
+   *
+   * The segments are drawn as by draw_lines(std::vector<line_segment> const &).
+   *
+   * @param items The container (e.g., a std::vector of the user's structs, or a strided_view). It must have size()
+   *              and operator[].
+   * @param segment_of Called as segment_of(items[i]) to get the i-th segment, in the current coordinate system
+   *                   (world or screen). By default, the elements must be line_segments.
+   */
+  template <typename Range, typename Projection = identity_projection>
+  void draw_lines(Range const &items, Projection segment_of = Projection());
+
+  /**
+   * Draw many filled rectangles read in place from any container, without copying them into a std::vector first.
+   *
+   * @param items The container. It must have size() and operator[].
+   * @param rectangle_of Called as rectangle_of(items[i]) to get the i-th rectangle, in the current coordinate system.
+   *
+   * @see draw_lines(Range const &, Projection)
+   */
+  template <typename Range, typename Projection = identity_projection>
+  void fill_rectangles(Range const &items, Projection rectangle_of = Projection());
+
+  /**
+   * Draw many arrows read in place from any container, without copying them into a std::vector first.
+   *
+   * @param items The container. It must have size() and operator[].
+   * @param segment_of Called as segment_of(items[i]) to get the i-th arrow, in the current coordinate system.
+   * @param head_size The length of the heads, in pixels.
+   *
+   * @see draw_lines(Range const &, Projection)
+   */
+  template <typename Range, typename Projection>
+  void draw_arrows(Range const &items, Projection segment_of, double head_size);
+
+  /**
+   * Draw the edges of a graph (e.g., the connections of a netlist) in the current color and line width.
+   *
+   * The graph is given in compressed sparse row (CSR) form: the edges leaving node u go to the nodes
+   * edge_targets[edge_offsets[u]], ..., edge_targets[edge_offsets[u + 1] - 1]. An edge listed in both directions is
+   * drawn twice. Self-loops (edges from a node to itself) and edges to nodes that do not exist are not drawn. Edges
+   * whose bounding box is outside of the visible world are skipped, the others are transformed and drawn as a single
+   * batch (see draw_lines).
+   *
+   * @param nodes The position of each node, in the current coordinate system (world or screen).
+   * @param edge_offsets The first edge of each node, with one more element giving the number of edges.
+   * @param edge_targets The node at the end of each edge.
+   * @param short_edge_mode How to draw edges shorter than a pixel.
+   */
+  void draw_graph(std::vector<point2d> const &nodes,
+      std::vector<std::uint32_t> const &edge_offsets,
+      std::vector<std::uint32_t> const &edge_targets,
+      short_edges short_edge_mode = short_edges::draw);
+
   /**
    * Draw a filled polygon 
    * The polygon can have an arbitrary shape and be convex or non-convex, but must be simple (no holes). 
@@ -382,6 +662,21 @@ public:
    */
   void fill_poly(std::vector<point2d> const &points);
 
+  /**
+   * Fill a path built beforehand. The path is transformed by cairo with the current coordinate system's transform,
+   * rather than point by point.
+   *
+   * @param p The path, in the current coordinate system (world or screen).
+   */
+  void fill_path(path const &p);
+
+  /**
+   * Draw the outline of a path built beforehand, with the current line width in pixels.
+   *
+   * @param p The path, in the current coordinate system (world or screen).
+   */
+  void draw_path(path const &p);
+
   /**
    * Draw the outline of an elliptic arc
    *
@@ -488,6 +783,9 @@ public:
 protected:
   // Only the canvas class can create a renderer.
   friend class canvas;
+  friend class scene;
+  template <t_coordinate_system System>
+  friend class coordinate_view;
 
   /**
    * A callback for transforming points from one coordinate system to another.
@@ -499,16 +797,22 @@ protected:
    *
    * @param cairo The cairo graphics state.
    * @param transform The function to use to transform points to cairo's coordinate system.
+   * @param use_x11 false to draw with cairo only, even on an X11 surface (see render_backend).
    */
-  renderer(cairo_t *cairo, transform_fn transform, camera *m_camera, cairo_surface_t *m_surface);
+  renderer(cairo_t *cairo,
+      transform_fn transform,
+      camera *m_camera,
+      cairo_surface_t *m_surface,
+      bool use_x11 = true);
 
   /**
    * Update the renderer when the cairo surface/context changes
    *
    * @param cairo The new cairo graphics state
    * @param m_surface The new cairo surface
+   * @param use_x11 false to draw with cairo only, even on an X11 surface.
    */
-  void update_renderer(cairo_t *cairo, cairo_surface_t *m_surface);
+  void update_renderer(cairo_t *cairo, cairo_surface_t *m_surface, bool use_x11 = true);
 
 private:
   void draw_rectangle_path(point2d start, point2d end, bool fill_flag);
@@ -520,6 +824,42 @@ private:
       double stretch_factor,
       bool fill_flag);
 
+  // The transform from the current coordinate system to cairo's; it only scales and translates
+  cairo_matrix_t current_matrix();
+
+  // Replace cairo's current path with a path built beforehand; returns false if the path is off screen
+  bool append_path(path const &p);
+
+  // Set the color from its packed form
+  void set_packed_color(packed_color c);
+
+  // Sort the indices of items by color into m_batch_order, and call draw(first, count) for each run of a color
+  template <typename Draw>
+  void for_each_color(std::vector<packed_color> const &colors, Draw &&draw);
+
+  // Cull the items get(0), ..., get(count - 1), given in System coordinates, and transform them to screen
+  // coordinates into m_batch_segments or m_batch_rectangles. The loops are templates so that the access to the
+  // caller's container is inlined rather than made through a call per item
+  template <t_coordinate_system System, typename Get>
+  void prepare_lines(Get &&get, std::size_t count);
+  template <t_coordinate_system System, typename Get>
+  void prepare_rectangles(Get &&get, std::size_t count);
+
+  // Prepare and submit the items get(0), ..., get(count - 1) in the current coordinate system
+  template <typename Get>
+  void draw_line_batch(Get &&get, std::size_t count);
+  template <typename Get>
+  void fill_rectangle_batch(Get &&get, std::size_t count);
+  template <typename Get>
+  void draw_arrow_batch(Get &&get, std::size_t count, double head_size);
+
+  // Send segments or rectangles in screen coordinates to X11 in one request, or to cairo as one path
+  void submit_lines(std::vector<line_segment> const &segments);
+  void submit_rectangles(std::vector<rectangle> const &rects);
+
+  // Draw the shafts in m_batch_segments and fill the heads in m_batch_heads
+  void submit_arrows();
+
   // Pre-clipping function
   bool rectangle_off_screen(rectangle rect);
 
@@ -570,7 +910,285 @@ private:
 
   // Current color
   color current_color = {0, 0, 0, 255};
+
+  // Whether X11 requests may be used when the surface belongs to the X server
+  bool m_use_x11;
+
+  // The end of the time slice, in microseconds of g_get_monotonic_time (0 if the frame is not time-sliced)
+  gint64 m_deadline = 0;
+
+  // The frame being drawn, and the canvas' latest frame (if any); the frame is cancelled once they differ
+  std::uint64_t m_frame = 0;
+  std::uint64_t const *m_latest_frame = nullptr;
+
+  // Where this slice starts, and where the next one starts if suspend was called
+  std::size_t m_resume_point = 0;
+  std::size_t m_next_resume_point = 0;
+  bool m_suspended = false;
+
+  // Reused between batches: item indices sorted by color, and the transformed items sent to X11
+  std::vector<std::uint32_t> m_batch_order;
+  std::vector<line_segment> m_batch_segments;
+  std::vector<line_segment> m_batch_short_segments;
+  std::vector<rectangle> m_batch_rectangles;
+  std::vector<point2d> m_batch_heads;
+#ifdef EZGL_USE_X11
+  std::vector<XSegment> m_x11_segments;
+  std::vector<XRectangle> m_x11_rectangles;
+#endif
 };
+
+template <t_coordinate_system System, typename Get>
+void renderer::prepare_lines(Get &&get, std::size_t count)
+{
+  rectangle visible = System == WORLD ? get_visible_world() : rectangle();
+  double const left = visible.left(), right = visible.right(), bottom = visible.bottom(), top = visible.top();
+
+  // Transform inline rather than through m_transform, which is called per point
+  cairo_matrix_t const m = current_matrix();
+
+  m_batch_segments.clear();
+
+  for(std::size_t i = 0; i < count; ++i) {
+    line_segment s = get(i);
+
+    // System is a constant, so the SCREEN loop has neither the test nor the transform
+    if(System == WORLD) {
+      bool outside = (std::max(s.start.x, s.end.x) < left) | (std::min(s.start.x, s.end.x) > right) |
+                     (std::max(s.start.y, s.end.y) < bottom) | (std::min(s.start.y, s.end.y) > top);
+      if(outside)
+        continue;
+
+      s.start = {m.xx * s.start.x + m.x0, m.yy * s.start.y + m.y0};
+      s.end = {m.xx * s.end.x + m.x0, m.yy * s.end.y + m.y0};
+    }
+
+    m_batch_segments.push_back(s);
+  }
+}
+
+template <t_coordinate_system System, typename Get>
+void renderer::prepare_rectangles(Get &&get, std::size_t count)
+{
+  rectangle visible = System == WORLD ? get_visible_world() : rectangle();
+  double const left = visible.left(), right = visible.right(), bottom = visible.bottom(), top = visible.top();
+
+  cairo_matrix_t const m = current_matrix();
+
+  m_batch_rectangles.clear();
+
+  for(std::size_t i = 0; i < count; ++i) {
+    rectangle const r = get(i);
+    point2d start = r.bottom_left();
+    point2d end = r.top_right();
+
+    if(System == WORLD) {
+      bool outside = (end.x < left) | (start.x > right) | (end.y < bottom) | (start.y > top);
+      if(outside)
+        continue;
+
+      start = {m.xx * start.x + m.x0, m.yy * start.y + m.y0};
+      end = {m.xx * end.x + m.x0, m.yy * end.y + m.y0};
+    }
+
+    m_batch_rectangles.push_back({start, end});
+  }
+}
+
+template <typename Get>
+void renderer::draw_line_batch(Get &&get, std::size_t count)
+{
+  if(current_coordinate_system == WORLD)
+    prepare_lines<WORLD>(get, count);
+  else
+    prepare_lines<SCREEN>(get, count);
+
+  submit_lines(m_batch_segments);
+}
+
+template <typename Get>
+void renderer::fill_rectangle_batch(Get &&get, std::size_t count)
+{
+  if(current_coordinate_system == WORLD)
+    prepare_rectangles<WORLD>(get, count);
+  else
+    prepare_rectangles<SCREEN>(get, count);
+
+  submit_rectangles(m_batch_rectangles);
+}
+
+template <typename Get>
+void renderer::draw_arrow_batch(Get &&get, std::size_t count, double head_size)
+{
+  bool world = current_coordinate_system == WORLD;
+  cairo_matrix_t const m = current_matrix();
+
+  // Heads may reach half their width beyond the segment's bounding box
+  rectangle visible = world ? get_visible_world() : rectangle();
+  double margin_x = world ? head_size / std::abs(m.xx) : 0;
+  double margin_y = world ? head_size / std::abs(m.yy) : 0;
+
+  m_batch_segments.clear();
+  m_batch_heads.clear();
+
+  for(std::size_t i = 0; i < count; ++i) {
+    line_segment const s = get(i);
+    if(world && (std::max(s.start.x, s.end.x) + margin_x < visible.left() ||
+                    std::min(s.start.x, s.end.x) - margin_x > visible.right() ||
+                    std::max(s.start.y, s.end.y) + margin_y < visible.bottom() ||
+                    std::min(s.start.y, s.end.y) - margin_y > visible.top()))
+      continue;
+
+    point2d tail = {m.xx * s.start.x + m.x0, m.yy * s.start.y + m.y0};
+    point2d tip = {m.xx * s.end.x + m.x0, m.yy * s.end.y + m.y0};
+
+    double dx = tip.x - tail.x;
+    double dy = tip.y - tail.y;
+    double length = std::sqrt(dx * dx + dy * dy);
+    if(length == 0)
+      continue;
+
+    dx /= length;
+    dy /= length;
+
+    // The shaft stops at the base of the head so that line caps do not show through its tip
+    point2d base = {tip.x - dx * head_size, tip.y - dy * head_size};
+    if(length > head_size)
+      m_batch_segments.push_back({tail, base});
+
+    double half_width = head_size / 2;
+    m_batch_heads.push_back(tip);
+    m_batch_heads.push_back({base.x - dy * half_width, base.y + dx * half_width});
+    m_batch_heads.push_back({base.x + dy * half_width, base.y - dx * half_width});
+  }
+
+  submit_arrows();
+}
+
+template <typename Range, typename Projection>
+void renderer::draw_lines(Range const &items, Projection segment_of)
+{
+  draw_line_batch([&](std::size_t i) -> line_segment { return segment_of(items[i]); }, items.size());
+}
+
+template <typename Range, typename Projection>
+void renderer::fill_rectangles(Range const &items, Projection rectangle_of)
+{
+  fill_rectangle_batch([&](std::size_t i) -> rectangle { return rectangle_of(items[i]); }, items.size());
+}
+
+template <typename Range, typename Projection>
+void renderer::draw_arrows(Range const &items, Projection segment_of, double head_size)
+{
+  draw_arrow_batch([&](std::size_t i) -> line_segment { return segment_of(items[i]); }, items.size(), head_size);
+}
+
+/**
+ * A renderer fixed to one coordinate system at compile time, for code that draws many primitives in the same system.
+ *
+ * The batch functions of a view run loops instantiated in the caller for System and for the projection: they
+ * neither test the coordinate system per item nor call through a pointer per item or point, so culling and
+ * transforming in world coordinates are a few inlined multiply-adds and one culling test, and screen coordinates
+ * are copied untouched.
+ *
+ * The renderer's coordinate system is set to System for the lifetime of the view and restored afterwards. The other
+ * functions of the renderer are reached through operator->:
+ *
+ *     world_renderer world(g);
+ *     world.draw_lines(wires, [](wire const &w) { return w.shape; });
+ *     world->draw_text(label_position, "net 7");
+ */
+template <t_coordinate_system System>
+class coordinate_view {
+public:
+  /**
+   * Create a view and switch the renderer to System.
+   *
+   * @param g The renderer to draw with.
+   */
+  explicit coordinate_view(renderer *g) : m_renderer(g), m_saved_system(g->current_coordinate_system)
+  {
+    m_renderer->current_coordinate_system = System;
+  }
+
+  /**
+   * Restore the renderer's coordinate system.
+   */
+  ~coordinate_view()
+  {
+    m_renderer->current_coordinate_system = m_saved_system;
+  }
+
+  coordinate_view(coordinate_view const &) = delete;
+  coordinate_view &operator=(coordinate_view const &) = delete;
+
+  /**
+   * Access the other functions of the renderer.
+   */
+  renderer *operator->() const
+  {
+    return m_renderer;
+  }
+
+  /**
+   * Draw a line, as by renderer::draw_line.
+   */
+  void draw_line(point2d start, point2d end)
+  {
+    line_segment const s = {start, end};
+    m_renderer->prepare_lines<System>([&s](std::size_t) { return s; }, 1);
+    m_renderer->submit_lines(m_renderer->m_batch_segments);
+  }
+
+  /**
+   * Draw a filled rectangle, as by renderer::fill_rectangle.
+   */
+  void fill_rectangle(rectangle const &r)
+  {
+    m_renderer->prepare_rectangles<System>([&r](std::size_t) { return r; }, 1);
+    m_renderer->submit_rectangles(m_renderer->m_batch_rectangles);
+  }
+
+  /**
+   * Draw many line segments in the current color and line width.
+   *
+   * @see renderer::draw_lines(Range const &, Projection)
+   */
+  template <typename Range, typename Projection = identity_projection>
+  void draw_lines(Range const &items, Projection segment_of = Projection())
+  {
+    m_renderer->prepare_lines<System>(
+        [&](std::size_t i) -> line_segment { return segment_of(items[i]); }, items.size());
+    m_renderer->submit_lines(m_renderer->m_batch_segments);
+  }
+
+  /**
+   * Draw many filled rectangles in the current color.
+   *
+   * @see renderer::fill_rectangles(Range const &, Projection)
+   */
+  template <typename Range, typename Projection = identity_projection>
+  void fill_rectangles(Range const &items, Projection rectangle_of = Projection())
+  {
+    m_renderer->prepare_rectangles<System>(
+        [&](std::size_t i) -> rectangle { return rectangle_of(items[i]); }, items.size());
+    m_renderer->submit_rectangles(m_renderer->m_batch_rectangles);
+  }
+
+private:
+  renderer *m_renderer;
+  t_coordinate_system m_saved_system;
+};
+
+/**
+ * A renderer fixed to world coordinates.
+ */
+using world_renderer = coordinate_view<WORLD>;
+
+/**
+ * A renderer fixed to screen coordinates.
+ */
+using screen_renderer = coordinate_view<SCREEN>;
 }
 
 #endif //EZGL_GRAPHICS_HPP
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_PATH_HPP
+#define EZGL_PATH_HPP
+
+#include "ezgl/point.hpp"
+#include "ezgl/rectangle.hpp"
+
+#include <cairo.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * A shape built once, in world coordinates, and drawn any number of times with renderer::fill_path or
+ * renderer::draw_path.
+ *
+ * renderer::fill_poly and the arc functions transform every point and rebuild the cairo path on each call, so a
+ * complex shape costs as much on every pan and zoom as the first time it was drawn. A path keeps its segments in
+ * cairo's own format instead: drawing it sets cairo's transformation matrix to the camera's world to screen transform and
+ * appends the whole path at once, so cairo transforms the points while it converts the path for rasterization.
+ *
+ * Arcs are stored as cubic Bézier curves. The segments are kept as doubles, in world coordinates, so they are not
+ * rounded to cairo's fixed-point device coordinates until they are drawn at a given zoom level.
+ */
+class path {
+public:
+  /**
+   * Start a new sub-path at a point.
+   */
+  void move_to(point2d point);
+
+  /**
+   * Add a line from the current point to a point. Starts a new sub-path if there is no current point.
+   */
+  void line_to(point2d point);
+
+  /**
+   * Add a circular arc.
+   *
+   * A line is added from the current point to the start of the arc, if there is a current point. Call move_to(center)
+   * first and close() after to make a sector.
+   *
+   * @param center The center of the arc.
+   * @param radius The radius of the arc.
+   * @param start_angle The starting angle of the arc, in degrees counter-clockwise from the positive x axis.
+   * @param extent_angle The extent of the arc, in degrees counter-clockwise. Negative extents go clockwise.
+   */
+  void arc(point2d center, double radius, double start_angle, double extent_angle);
+
+  /**
+   * Close the current sub-path with a line back to its first point.
+   */
+  void close();
+
+  /**
+   * Add a polygon as a closed sub-path.
+   *
+   * @param points The vertices of the polygon. There must be at least 2 points.
+   */
+  void add_polygon(std::vector<point2d> const &points);
+
+  /**
+   * Add a rectangle as a closed sub-path.
+   */
+  void add_rectangle(rectangle r);
+
+  /**
+   * Remove all segments.
+   */
+  void clear();
+
+  /**
+   * True if the path has no segments.
+   */
+  bool empty() const
+  {
+    return m_data.empty();
+  }
+
+  /**
+   * A box that contains the path. It contains the control points of arcs, so it may be slightly larger than the arcs.
+   */
+  rectangle bounds() const
+  {
+    return {{m_x0, m_y0}, {m_x1, m_y1}};
+  }
+
+  /**
+   * The path in cairo's format, for cairo_append_path. It refers to the path's storage, so it is invalidated when the
+   * path is modified.
+   */
+  cairo_path_t cairo_path() const
+  {
+    return {CAIRO_STATUS_SUCCESS, const_cast<cairo_path_data_t *>(m_data.data()), static_cast<int>(m_data.size())};
+  }
+
+private:
+  // Append a header and its points
+  void add_element(cairo_path_data_type_t type, point2d const *points, int count);
+
+  // Add a cubic Bézier curve from the current point
+  void curve_to(point2d control1, point2d control2, point2d end);
+
+  // The segments, as cairo headers followed by their points
+  std::vector<cairo_path_data_t> m_data;
+
+  // The current point and the first point of the current sub-path
+  bool m_has_current_point = false;
+  point2d m_current = {0, 0};
+  point2d m_start = {0, 0};
+
+  // The bounding box of all points
+  double m_x0 = 0, m_y0 = 0, m_x1 = 0, m_y1 = 0;
+};
+}
+
+#endif //EZGL_PATH_HPP
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_QUADTREE_HPP
+#define EZGL_QUADTREE_HPP
+
+#include "ezgl/point.hpp"
+#include "ezgl/rectangle.hpp"
+#include "ezgl/scene.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * Identifies an object of a loose_quadtree. Handles are reused after the object is removed.
+ */
+using quadtree_handle = std::uint32_t;
+
+/**
+ * A handle that refers to no object.
+ */
+constexpr quadtree_handle NO_QUADTREE_HANDLE = UINT32_MAX;
+
+/**
+ * The largest depth of a loose_quadtree.
+ */
+constexpr std::uint32_t QUADTREE_MAX_DEPTH = 32;
+
+/**
+ * The number of objects a node of a loose_quadtree holds before it gets children.
+ */
+constexpr std::uint32_t QUADTREE_NODE_CAPACITY = 16;
+
+/**
+ * A spatial index of axis-aligned boxes that can be updated cheaply, for objects that move every frame.
+ *
+ * This is a loose quadtree: each object is stored in exactly one node, chosen by the object's center, whose cell is at
+ * least as large as the object. The loose bounds of a node are its cell grown by half a cell on each side, so they
+ * contain every object stored in the node. Objects go to the deepest node their size allows, except that a node only
+ * gets children once it holds QUADTREE_NODE_CAPACITY objects, so sparse regions are not deep chains of nearly empty
+ * nodes. Inserting, removing and moving an object take O(log(world size / object size)) time, and moving an object
+ * within its node's cell takes O(1) time; the index is never rebuilt. Empty nodes are freed.
+ *
+ * Objects whose center is outside of the world given to the constructor are stored at the root, which every query
+ * visits.
+ *
+ * Each canvas owns a loose_quadtree (see canvas::get_dynamic_index) that canvas::pick searches.
+ */
+class loose_quadtree {
+public:
+  /**
+   * Create an empty index.
+   *
+   * @param world The region where most objects are. It does not limit where objects can be.
+   * @param max_depth The depth of the deepest nodes, at most QUADTREE_MAX_DEPTH. Objects smaller than a cell at this
+   *                  depth share its node.
+   */
+  explicit loose_quadtree(rectangle world, std::uint32_t max_depth = 16);
+
+  /**
+   * Add an object.
+   *
+   * @param bounds The bounding box of the object.
+   * @param id (optional) A tag used to identify the object.
+   *
+   * @return The handle of the object, used to move or remove it.
+   */
+  quadtree_handle insert(rectangle const &bounds, primitive_id id = 0);
+
+  /**
+   * Remove an object.
+   */
+  void remove(quadtree_handle handle);
+
+  /**
+   * Change the bounding box of an object. Removed objects are ignored.
+   */
+  void move(quadtree_handle handle, rectangle const &bounds);
+
+  /**
+   * Get the bounding box of an object.
+   */
+  rectangle const &bounds(quadtree_handle handle) const
+  {
+    return m_objects[handle].bounds;
+  }
+
+  /**
+   * Get the tag of an object.
+   */
+  primitive_id id(quadtree_handle handle) const
+  {
+    return m_objects[handle].id;
+  }
+
+  /**
+   * The number of objects.
+   */
+  std::size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * Remove all objects.
+   */
+  void clear();
+
+  /**
+   * Visit every object whose bounding box intersects a region.
+   *
+   * @param region The region to search.
+   * @param visit A function called as visit(quadtree_handle, rectangle const &bounds, primitive_id) for each object,
+   *              in no particular order. It must not modify the index.
+   */
+  template <typename Visitor>
+  void query(rectangle const &region, Visitor &&visit) const;
+
+  /**
+   * Find the object at a point.
+   *
+   * @param point The point.
+   * @param tolerance How far the point may be outside of an object's bounding box.
+   *
+   * @return The smallest object whose bounding box contains the point, or NO_QUADTREE_HANDLE if there is none.
+   */
+  quadtree_handle pick(point2d point, double tolerance = 0) const;
+
+private:
+  static constexpr std::uint32_t NONE = UINT32_MAX;
+
+  struct node {
+    // The center and half the size of the node's cell
+    double center_x, center_y, half_size;
+
+    std::uint32_t parent;
+    std::uint32_t children[4];
+    std::uint32_t num_children;
+
+    // A doubly-linked list of the objects stored in the node, threaded through the objects
+    std::uint32_t first_object;
+    std::uint32_t num_objects;
+
+    std::uint32_t depth;
+
+    // Test if the loose bounds of the node intersect a region given by its edges
+    bool loosely_intersects(double left, double bottom, double right, double top) const
+    {
+      double loose = 2 * half_size;
+      return !(center_x + loose < left || center_x - loose > right || center_y + loose < bottom ||
+               center_y - loose > top);
+    }
+  };
+
+  struct object {
+    rectangle bounds;
+    primitive_id id;
+
+    // The edges of the bounding box, so queries do not have to sort the corners
+    double x0, y0, x1, y1;
+
+    // The node holding the object (NONE if the slot is free), and the neighbours in the node's list
+    std::uint32_t node;
+    std::uint32_t previous, next;
+  };
+
+  // The depth of the deepest node that can hold an object of this size
+  std::uint32_t depth_for(rectangle const &bounds) const;
+
+  // Find (or create) the node that should hold a new or relocated object
+  std::uint32_t node_for(rectangle const &bounds);
+
+  // Allocate a child of a node
+  std::uint32_t add_child(std::uint32_t parent, int quadrant);
+
+  // Set the bounding box of an object
+  void set_bounds(quadtree_handle handle, rectangle const &bounds);
+
+  // Link and unlink an object from its node's list
+  void link(quadtree_handle handle, std::uint32_t node_index);
+  void unlink(quadtree_handle handle);
+
+  // Free empty nodes without children, starting at a node and going up
+  void prune(std::uint32_t node_index);
+
+  // The cell of the root
+  rectangle m_world;
+  std::uint32_t m_max_depth;
+
+  // The nodes; the root is node 0. Freed nodes are chained through parent.
+  std::vector<node> m_nodes;
+  std::uint32_t m_free_node = NONE;
+
+  // The objects, indexed by handle. Freed slots are chained through next.
+  std::vector<object> m_objects;
+  std::uint32_t m_free_object = NONE;
+  std::size_t m_size = 0;
+};
+
+template <typename Visitor>
+void loose_quadtree::query(rectangle const &region, Visitor &&visit) const
+{
+  // Each level adds at most 3 nodes to the stack
+  std::uint32_t stack[4 * (QUADTREE_MAX_DEPTH + 1)];
+  std::size_t top = 0;
+  stack[top++] = 0;
+
+  double const left = region.left();
+  double const bottom = region.bottom();
+  double const right = region.right();
+  double const top_edge = region.top();
+
+  while(top > 0) {
+    node const &n = m_nodes[stack[--top]];
+
+    for(std::uint32_t i = n.first_object; i != NONE; i = m_objects[i].next) {
+      object const &o = m_objects[i];
+      if(!(o.x1 < left || o.x0 > right || o.y1 < bottom || o.y0 > top_edge))
+        visit(static_cast<quadtree_handle>(i), o.bounds, o.id);
+    }
+
+    for(std::uint32_t child : n.children) {
+      if(child != NONE && m_nodes[child].loosely_intersects(left, bottom, right, top_edge))
+        stack[top++] = child;
+    }
+  }
+}
+}
+
+#endif //EZGL_QUADTREE_HPP
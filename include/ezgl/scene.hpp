@@ -0,0 +1,1127 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_SCENE_HPP
+#define EZGL_SCENE_HPP
+
+#include "ezgl/cache.hpp"
+#include "ezgl/color.hpp"
+#include "ezgl/point.hpp"
+#include "ezgl/rectangle.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ezgl {
+
+class renderer;
+
+/**
+ * A user-defined tag attached to a primitive of a scene, used to identify it when picking or selecting.
+ *
+ * The value 0 means "untagged".
+ */
+using primitive_id = std::uint32_t;
+
+/**
+ * The kinds of primitives a scene can hold.
+ */
+enum class primitive_kind : std::uint8_t {
+  /**
+   * A filled axis-aligned rectangle.
+   */
+  fill_rectangle,
+
+  /**
+   * The outline of an axis-aligned rectangle.
+   */
+  rectangle,
+
+  /**
+   * A line segment.
+   */
+  line,
+
+  /**
+   * A filled polygon.
+   */
+  fill_poly,
+
+  /**
+   * A placement of a cell (see scene::add_instance).
+   */
+  instance
+};
+
+/**
+ * The drawing attributes shared by the primitives of a scene.
+ *
+ * This type is stored as-is in scene files; do not change its layout without changing SCENE_FILE_VERSION.
+ */
+struct scene_style {
+  /**
+   * The color of the primitive.
+   */
+  std::uint8_t red, green, blue, alpha;
+
+  /**
+   * The line width in pixels, for outlines and lines.
+   */
+  std::int32_t line_width;
+
+  /**
+   * The color of the style.
+   */
+  ezgl::color color() const
+  {
+    return {red, green, blue, alpha};
+  }
+};
+
+/**
+ * A primitive of a scene.
+ *
+ * This type is stored as-is in scene files; do not change its layout without changing SCENE_FILE_VERSION.
+ */
+struct scene_primitive {
+  /**
+   * The corners of a rectangle, the end points of a line or the bounding box of a polygon, in world coordinates.
+   */
+  double x0, y0, x1, y1;
+
+  /**
+   * The user-defined tag of the primitive.
+   */
+  primitive_id id;
+
+  /**
+   * The index of the primitive's style in the scene's style table; for instances, the index of the cell.
+   */
+  std::uint32_t style;
+
+  /**
+   * For polygons, the index of the first vertex in the scene's point pool; for instances, the index of the placement
+   * in the scene's transform table.
+   */
+  std::uint32_t first_point;
+
+  /**
+   * For polygons, the number of vertices.
+   */
+  std::uint32_t num_points;
+
+  /**
+   * The position of the primitive in drawing order within its layer (insertion order).
+   */
+  std::uint32_t order;
+
+  /**
+   * What the primitive is.
+   */
+  primitive_kind kind;
+
+  /**
+   * The layer of the primitive. Lower layers are drawn first.
+   */
+  std::uint8_t layer;
+
+  /**
+   * Unused; keeps the layout identical on all platforms.
+   */
+  std::uint8_t reserved[2];
+
+  /**
+   * The bounding box of the primitive.
+   */
+  rectangle bounds() const
+  {
+    return {{std::min(x0, x1), std::min(y0, y1)}, {std::max(x0, x1), std::max(y0, y1)}};
+  }
+};
+
+static_assert(sizeof(scene_primitive) == 56, "scene_primitive is part of the scene file format");
+
+/**
+ * A node of the scene's spatial index (an R-tree packed with the Sort-Tile-Recursive algorithm).
+ *
+ * Leaves (level 0) refer to a contiguous range of primitives, other nodes to a contiguous range of nodes one level
+ * down. This type is stored as-is in scene files.
+ */
+struct scene_node {
+  /**
+   * The bounding box of everything below this node.
+   */
+  double x0, y0, x1, y1;
+
+  /**
+   * The index of the first child node (or the first primitive for a leaf).
+   */
+  std::uint32_t first;
+
+  /**
+   * The number of children (or primitives for a leaf).
+   */
+  std::uint32_t count;
+
+  /**
+   * The height of the node above the leaves; leaves are at level 0.
+   */
+  std::uint32_t level;
+
+  /**
+   * Unused; keeps the layout identical on all platforms.
+   */
+  std::uint32_t reserved;
+
+  /**
+   * Test if the node's bounding box overlaps a region.
+   */
+  bool intersects(rectangle const &region) const
+  {
+    return !(x1 < region.left() || x0 > region.right() || y1 < region.bottom() || y0 > region.top());
+  }
+};
+
+static_assert(sizeof(scene_node) == 48, "scene_node is part of the scene file format");
+
+/**
+ * A page of a scene file: the primitives and polygon vertices below one node of the spatial index.
+ *
+ * Primitives are stored in depth-first order of the spatial index, so every subtree covers a contiguous range of
+ * primitives (and of polygon vertices). Pages are the unit in which a scene is streamed from disk. This type is stored
+ * as-is in scene files.
+ */
+struct scene_page {
+  /**
+   * The index of the first primitive of the page.
+   */
+  std::uint64_t first_primitive;
+
+  /**
+   * The number of primitives in the page.
+   */
+  std::uint64_t primitive_count;
+
+  /**
+   * The index of the first polygon vertex of the page.
+   */
+  std::uint64_t first_point;
+
+  /**
+   * The number of polygon vertices in the page.
+   */
+  std::uint64_t point_count;
+};
+
+/**
+ * The orientation of a cell instance: a counterclockwise rotation by a multiple of 90 degrees, optionally applied after
+ * mirroring about the x axis (as in GDSII and OASIS).
+ *
+ * Only these orientations are supported, so placed rectangles stay axis-aligned.
+ */
+enum class cell_orientation : std::uint8_t {
+  r0,
+  r90,
+  r180,
+  r270,
+  mirror_r0,
+  mirror_r90,
+  mirror_r180,
+  mirror_r270
+};
+
+/**
+ * The placement of a cell instance, which maps cell coordinates to the coordinates of the scene holding the instance.
+ *
+ * This type is stored as-is in scene files.
+ */
+struct scene_transform {
+  /**
+   * The transform maps (x, y) to (xx * x + xy * y + dx, yx * x + yy * y + dy).
+   */
+  double xx, xy, yx, yy, dx, dy;
+
+  /**
+   * Create the identity transform.
+   */
+  scene_transform() : xx(1), xy(0), yx(0), yy(1), dx(0), dy(0)
+  {
+  }
+
+  /**
+   * Create a placement.
+   *
+   * @param offset Where the origin of the cell is placed.
+   * @param orientation The orientation of the cell.
+   * @param magnification The scale of the cell; must be positive.
+   */
+  explicit scene_transform(point2d offset,
+      cell_orientation orientation = cell_orientation::r0,
+      double magnification = 1);
+
+  /**
+   * Transform a point.
+   */
+  point2d apply(point2d p) const
+  {
+    return {xx * p.x + xy * p.y + dx, yx * p.x + yy * p.y + dy};
+  }
+
+  /**
+   * Transform an axis-aligned rectangle.
+   */
+  rectangle apply(rectangle const &r) const
+  {
+    point2d a = apply(r.bottom_left());
+    point2d b = apply(r.top_right());
+
+    return {{std::min(a.x, b.x), std::min(a.y, b.y)}, {std::max(a.x, b.x), std::max(a.y, b.y)}};
+  }
+
+  /**
+   * Get the transform that undoes this one.
+   */
+  scene_transform inverse() const;
+
+  /**
+   * Combine two transforms: the result applies inner first, then outer.
+   */
+  friend scene_transform operator*(scene_transform const &outer, scene_transform const &inner);
+};
+
+static_assert(sizeof(scene_transform) == 48, "scene_transform is part of the scene file format");
+
+/**
+ * The version of the scene file format written by scene::save.
+ */
+constexpr std::uint32_t SCENE_FILE_VERSION = 3;
+
+/**
+ * The maximum number of children of a node of the scene's spatial index.
+ */
+constexpr std::uint32_t SCENE_NODE_CAPACITY = 16;
+
+/**
+ * The size in pixels of a block of the coverage mask used for occlusion culling (see scene::set_occlusion_culling).
+ */
+constexpr int SCENE_OCCLUSION_BLOCK = 8;
+
+/**
+ * The level of the spatial index whose nodes form the pages of a scene file (up to 16^3 = 4096 primitives per page).
+ */
+constexpr std::uint32_t SCENE_PAGE_LEVEL = 2;
+
+/**
+ * A read-only array whose elements are either owned or live in a memory-mapped file.
+ *
+ * Used by the scene to load files without copying or parsing them. Mutable access copies mapped elements into owned
+ * memory first.
+ */
+template <typename T>
+class scene_array {
+public:
+  /**
+   * A pointer to the first element.
+   */
+  T const *data() const
+  {
+    return m_mapped != nullptr ? m_mapped : m_owned.data();
+  }
+
+  /**
+   * The number of elements.
+   */
+  std::size_t size() const
+  {
+    return m_mapped != nullptr ? m_mapped_size : m_owned.size();
+  }
+
+  /**
+   * Test if there are no elements.
+   */
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  /**
+   * Access an element.
+   */
+  T const &operator[](std::size_t i) const
+  {
+    return data()[i];
+  }
+
+  /**
+   * An iterator to the first element.
+   */
+  T const *begin() const
+  {
+    return data();
+  }
+
+  /**
+   * An iterator past the last element.
+   */
+  T const *end() const
+  {
+    return data() + size();
+  }
+
+  /**
+   * Get the owned elements for modification, copying mapped elements first if necessary.
+   */
+  std::vector<T> &edit()
+  {
+    if(m_mapped != nullptr) {
+      m_owned.assign(m_mapped, m_mapped + m_mapped_size);
+      m_mapped = nullptr;
+      m_mapped_size = 0;
+    }
+
+    return m_owned;
+  }
+
+  /**
+   * Refer to elements owned by someone else (e.g., a memory-mapped file).
+   */
+  void map(T const *elements, std::size_t count)
+  {
+    m_owned.clear();
+    m_owned.shrink_to_fit();
+    m_mapped = elements;
+    m_mapped_size = count;
+  }
+
+  /**
+   * Remove all elements.
+   */
+  void clear()
+  {
+    m_owned.clear();
+    m_mapped = nullptr;
+    m_mapped_size = 0;
+  }
+
+private:
+  std::vector<T> m_owned;
+  T const *m_mapped = nullptr;
+  std::size_t m_mapped_size = 0;
+};
+
+/**
+ * What occlusion culling saved in the last draw of a scene (see scene::set_occlusion_culling).
+ */
+struct scene_occlusion_stats {
+  /**
+   * The number of primitives that intersect the visible world.
+   */
+  std::size_t visible = 0;
+
+  /**
+   * The number of those that were not drawn because opaque rectangles drawn after them cover them.
+   */
+  std::size_t culled = 0;
+
+  /**
+   * The sum of the on-screen areas of the visible primitives, divided by the area of the screen.
+   */
+  double overdraw_before = 0;
+
+  /**
+   * The sum of the on-screen areas of the primitives drawn, divided by the area of the screen.
+   */
+  double overdraw_after = 0;
+};
+
+class cell_raster_cache;
+class mapped_file;
+class scene_stream_reader;
+struct scene_file_header;
+
+/**
+ * A retained collection of primitives that ezgl can draw, cull and save without calling back into application code.
+ *
+ * Primitives are added once (e.g., when the design is loaded) and indexed with a bulk-loaded R-tree, so each redraw
+ * only visits the primitives that intersect the visible world. A scene can be saved to a compact binary file and loaded
+ * again by memory-mapping it: the primitive arrays, style table and spatial index are used directly from the file
+ * without parsing, so loading time does not depend on the size of the scene.
+ *
+ * Repeated content can be defined once as a cell (itself a scene) and placed many times with add_instance. Instances
+ * are culled by their bounding boxes, and a cell's primitives are only visited where an instance is visible.
+ *
+ * Each canvas owns a scene (see canvas::get_scene) that is drawn before the canvas' draw callback is called.
+ */
+class scene {
+public:
+  /**
+   * Create an empty scene.
+   */
+  scene();
+
+  /**
+   * Destructor.
+   */
+  ~scene();
+
+  /**
+   * Copies are disabled.
+   */
+  scene(scene const &) = delete;
+
+  /**
+   * Copies are disabled.
+   */
+  scene &operator=(scene const &) = delete;
+
+  /**
+   * Add a style to the style table.
+   *
+   * @param c The color of the primitives using the style.
+   * @param line_width The line width in pixels of outlines and lines using the style.
+   *
+   * @return The index of the style, to pass to the add_ functions.
+   */
+  std::uint32_t add_style(color c, int line_width = 0);
+
+  /**
+   * Change the color of a style, e.g., to switch color schemes without rebuilding the scene.
+   *
+   * @param style The index of the style returned by add_style.
+   * @param c The new color.
+   */
+  void set_style_color(std::uint32_t style, color c);
+
+  /**
+   * Add a filled rectangle.
+   *
+   * @param r The rectangle, in world coordinates.
+   * @param style The index of the style returned by add_style.
+   * @param id (optional) A tag used to identify the primitive.
+   * @param layer (optional) The layer of the primitive. Lower layers are drawn first.
+   */
+  void add_fill_rectangle(rectangle r, std::uint32_t style, primitive_id id = 0, std::uint8_t layer = 0);
+
+  /**
+   * Add the outline of a rectangle.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_rectangle(rectangle r, std::uint32_t style, primitive_id id = 0, std::uint8_t layer = 0);
+
+  /**
+   * Add a line segment.
+   *
+   * @param start The start point of the line, in world coordinates.
+   * @param end The end point of the line, in world coordinates.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_line(point2d start, point2d end, std::uint32_t style, primitive_id id = 0, std::uint8_t layer = 0);
+
+  /**
+   * Add a filled polygon.
+   *
+   * @param points The vertices of the polygon, in world coordinates. There must be at least 2 points.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_fill_poly(std::vector<point2d> const &points,
+      std::uint32_t style,
+      primitive_id id = 0,
+      std::uint8_t layer = 0);
+
+  /**
+   * Define a cell: a group of primitives, with its own style table, that can be placed many times with add_instance.
+   *
+   * Cells belong to the top-level scene; calling this on a cell adds the new cell to the top-level scene.
+   *
+   * @return The index of the new cell.
+   */
+  std::uint32_t add_cell();
+
+  /**
+   * Get a cell, to add its primitives. Add all primitives of a cell before placing it.
+   *
+   * @param index The index returned by add_cell.
+   */
+  scene &cell(std::uint32_t index);
+
+  /**
+   * The number of cells of the top-level scene.
+   */
+  std::size_t num_cells() const;
+
+  /**
+   * Place a cell. The cell's primitives are only drawn where the instance is visible.
+   *
+   * Once placed, no primitives can be added to the cell. A cell can only place cells that were defined before it.
+   *
+   * @param cell The index of the cell, returned by add_cell.
+   * @param placement The transform from the cell's coordinates to the coordinates of this scene.
+   * @param id (optional) A tag used to identify the instance.
+   * @param layer (optional) The layer of the instance. The whole cell is drawn at this point of the drawing order.
+   */
+  void add_instance(std::uint32_t cell,
+      scene_transform const &placement,
+      primitive_id id = 0,
+      std::uint8_t layer = 0);
+
+  /**
+   * Draw small cells from a cached raster instead of their primitives.
+   *
+   * Each cell is rendered once per zoom level and orientation into an image, which is then copied for each visible
+   * instance. The images are kept in a cache that is part of the application's cache budget (see cache_manager).
+   *
+   * @param max_pixels The largest on-screen area in pixels of a cell to rasterize, or 0 to always draw primitives.
+   */
+  void set_cell_raster_limit(std::size_t max_pixels);
+
+  /**
+   * Skip primitives hidden under opaque filled rectangles.
+   *
+   * Before drawing, the visible primitives are visited front to back against a coarse coverage mask of the screen
+   * (one entry per block of SCENE_OCCLUSION_BLOCK x SCENE_OCCLUSION_BLOCK pixels): filled rectangles of fully opaque
+   * styles mark the blocks they cover completely, and primitives whose blocks are all marked are not drawn. This
+   * pays off for dense layouts with much overdraw; see occlusion_stats().
+   *
+   * @param enabled true to cull hidden primitives.
+   */
+  void set_occlusion_culling(bool enabled)
+  {
+    m_occlusion_culling = enabled;
+  }
+
+  /**
+   * What occlusion culling saved in the last draw.
+   */
+  scene_occlusion_stats const &occlusion_stats() const
+  {
+    return m_occlusion_stats;
+  }
+
+  /**
+   * Merge filled rectangles that have the same color, layer and id into fewer, non-overlapping rectangles.
+   *
+   * The union of each group of rectangles is computed with a scanline sweep and stored as run-length spans: maximal
+   * horizontal runs, with runs of consecutive scanlines that have the same extent combined. Adjacent blocks (e.g., the
+   * cells of a routing channel) become a few rectangles, and overlapping ones are no longer drawn twice.
+   *
+   * The spans of a group are drawn at the position of its first rectangle in the drawing order of its layer, so call
+   * this on scenes where rectangles of different colors in the same layer do not overlap, as is usual for Manhattan
+   * layouts.
+   *
+   * The scene is rebuilt in memory: this needs about twice the memory of the primitives, and the sweep takes
+   * O(n log n) time in the number of rectangles. Scenes loaded, paged or streamed from a file are used in place and
+   * may be larger than memory, so they are left unchanged with a warning; merge the rectangles before saving instead.
+   *
+   * @return The number of primitives removed.
+   */
+  std::size_t merge_rectangles();
+
+  /**
+   * Remove all primitives, styles and cells.
+   */
+  void clear();
+
+  /**
+   * The number of primitives.
+   */
+  std::size_t size() const
+  {
+    return m_primitives.size();
+  }
+
+  /**
+   * Test if the scene has no primitives.
+   */
+  bool empty() const
+  {
+    return m_primitives.empty();
+  }
+
+  /**
+   * The bounding box of all primitives, in world coordinates.
+   */
+  rectangle bounds() const
+  {
+    return m_bounds;
+  }
+
+  /**
+   * The style table.
+   */
+  scene_array<scene_style> const &styles() const
+  {
+    return m_styles;
+  }
+
+  /**
+   * The primitives, in spatial index order.
+   */
+  scene_array<scene_primitive> const &primitives() const
+  {
+    return m_primitives;
+  }
+
+  /**
+   * The vertices of all polygons.
+   */
+  scene_array<point2d> const &points() const
+  {
+    return m_points;
+  }
+
+  /**
+   * Draw a primitive in world coordinates. Scenes and tile grids share this, so they draw primitives the same way.
+   *
+   * @param g The renderer to draw with.
+   * @param p The primitive. Instances are skipped, since only their scene knows the cells.
+   * @param style The style to apply first, or nullptr to keep the renderer's color and line width (e.g., when they
+   * were set for a run of primitives, or when drawing in a flat color).
+   * @param points The vertices that the first_point of polygons refers to.
+   * @param scratch Reused between calls to pass polygon vertices to the renderer.
+   * @param to_target If not null, the transform applied to the primitive's coordinates.
+   */
+  static void draw_primitive(renderer *g,
+      scene_primitive const &p,
+      scene_style const *style,
+      point2d const *points,
+      std::vector<point2d> &scratch,
+      scene_transform const *to_target = nullptr);
+
+  /**
+   * (Re)build the spatial index.
+   *
+   * Called automatically before drawing or querying a scene that has been modified; call it explicitly to control
+   * when the cost is paid. Building reorders the primitives.
+   */
+  void build();
+
+  /**
+   * Visit every primitive whose bounding box intersects a region.
+   *
+   * @param region The region, in world coordinates.
+   * @param visit A function called as visit(scene_primitive const &) for each primitive, in no particular order.
+   */
+  template <typename Visitor>
+  void query(rectangle const &region, Visitor &&visit);
+
+  /**
+   * Find the topmost tagged primitive at a point.
+   *
+   * Lines and outlines are hit near their segments, filled rectangles and polygons anywhere inside them, and instances
+   * where a primitive of their cell is hit.
+   *
+   * @param point The point, in world coordinates.
+   * @param tolerance How far, in world units, the point may be from a primitive.
+   *
+   * @return The id of the primitive drawn last among those at the point, or 0 if there is none.
+   */
+  primitive_id pick(point2d point, double tolerance = 0);
+
+  /**
+   * Draw the primitives that intersect the renderer's visible world, in layer and insertion order.
+   *
+   * @param g The renderer to draw with. Its color and line width are changed.
+   */
+  void draw(renderer *g);
+
+  /**
+   * Draw the tagged primitives that intersect a region into an ID buffer, each in a flat color that identifies it.
+   *
+   * A primitive is drawn in the color (r, g, b) = the 24-bit number of its slot, s = (r << 16) | (g << 8) | b, and its
+   * id is appended to id_slots at index s; pixels that no tagged primitive covers are left untouched. Instances are
+   * drawn with the id of the instance. The renderer should draw without antialiasing so colors are not blended.
+   *
+   * Primitives just outside the region whose lines or outlines reach into it are drawn too, so the caller should clip
+   * to the region when it redraws part of a buffer.
+   *
+   * @param g The renderer to draw with. Its color and line width are changed.
+   * @param region The region to draw, in world coordinates.
+   * @param id_slots The ids of the slots; its first element (slot 0) means "no primitive".
+   */
+  void draw_ids(renderer *g, rectangle const &region, std::vector<primitive_id> &id_slots);
+
+  /**
+   * Draw the primitives that intersect a region into an index buffer, each in a flat color that identifies its style.
+   *
+   * A primitive is drawn in the color (r, g, b) = the 24-bit number (r << 16) | (g << 8) | b = 1 + the index of its
+   * style in the palette (see palette), so that color 0 means "no primitive". The renderer should draw without
+   * antialiasing so colors are not blended. Mapping the buffer through the palette gives the colors of the scene, and
+   * after the styles are changed (see set_style_color), only that mapping has to be done again.
+   *
+   * @param g The renderer to draw with. Its color and line width are changed.
+   * @param region The region to draw, in world coordinates.
+   */
+  void draw_style_indices(renderer *g, rectangle const &region);
+
+  /**
+   * Get the colors of the styles of the scene and of its cells, as drawn by draw_style_indices.
+   *
+   * @param lut Set to the colors, indexed by the numbers drawn by draw_style_indices, as premultiplied ARGB32 pixels
+   *            (the format of CAIRO_FORMAT_ARGB32). Its first element (for "no primitive") is transparent.
+   */
+  void palette(std::vector<std::uint32_t> &lut);
+
+  /**
+   * Draw the primitives that have some ids in a single style, e.g., to highlight them over the rest of the scene.
+   *
+   * Primitives are found through an index of ids, built when first needed (which reads every primitive once), so the
+   * cost of drawing depends only on the number of primitives drawn. For a paged or streamed scene, only the pages that
+   * have been drawn or read are indexed, each once as it becomes ready, and only their primitives are highlighted.
+   * Instances are drawn with all of their cell's primitives in the style's color.
+   *
+   * @param g The renderer to draw with. Its color and line width are changed.
+   * @param ids The ids of the primitives to draw.
+   * @param style The color and line width to draw them with.
+   * @param bounds Set to the bounding box of the primitives drawn, in world coordinates.
+   *
+   * @return false if no primitive has any of the ids.
+   */
+  bool draw_highlight(renderer *g, std::vector<primitive_id> const &ids, scene_style const &style, rectangle &bounds);
+
+  /**
+   * Save the scene (including its spatial index) to a binary file.
+   *
+   * @param file_path The path of the file to create.
+   *
+   * @return true if the file was written.
+   */
+  bool save(const char *file_path);
+
+  /**
+   * Replace the contents of the scene with a file written by save().
+   *
+   * The file is memory-mapped and used in place. It must not be modified while the scene refers to it. Loading only
+   * reads and checks the header, the styles and the index above the pages, so its cost does not grow with the number
+   * of primitives. Each page is checked the first time it is drawn or queried, and a corrupt page is skipped with a
+   * warning.
+   *
+   * @param file_path The path of the file to load.
+   *
+   * @return true if the file was loaded; false (leaving the scene empty) if it is missing or not a valid scene file.
+   */
+  bool load(const char *file_path);
+
+  /**
+   * Replace the contents of the scene with a file written by save(), keeping it on disk.
+   *
+   * Like load(), the file is memory-mapped, but its pages are managed explicitly so the scene can be much larger than
+   * memory: draw() asks the system to read the pages that intersect the visible world (and, ahead of time, the pages
+   * around it in the direction the view is moving), and keeps the pages it has used in a cache that is part of the
+   * application's cache budget (see cache_manager). Pages evicted from the cache are handed back to the system.
+   *
+   * Queries outside draw() still see every primitive; pages they touch are read from disk on demand.
+   *
+   * @param file_path The path of the file to open.
+   * @param cache_weight The share of the global cache budget the page cache is entitled to, relative to other caches.
+   *
+   * @return true if the file was opened; false (leaving the scene empty) if it is missing or not a valid scene file.
+   */
+  bool load_paged(const char *file_path, double cache_weight = 1.0);
+
+  /**
+   * Test if the scene was opened with load_paged().
+   */
+  bool is_paged() const
+  {
+    return m_page_cache != nullptr;
+  }
+
+  /**
+   * Replace the contents of the scene with a file written by save(), reading it on a background thread.
+   *
+   * The spatial index is read immediately; pages of primitives become visible as they arrive, starting with the
+   * pages that intersect the visible world of the last draw. Call update_stream() periodically from the GTK thread to
+   * make newly read pages visible (canvas::stream_scene does this for the canvas' scene).
+   *
+   * No primitives can be added to the scene while it is streaming.
+   *
+   * @param file_path The path of the file to read.
+   * @param memory_budget The maximum number of bytes of primitives and vertices to keep in memory, or 0 to read the
+   *                      whole file. With a budget, only pages that intersect the visible world are read, and pages
+   *                      far from it are dropped to make room, so scenes larger than RAM can be viewed.
+   *
+   * @return true if the file was opened and its index was read.
+   */
+  bool stream(const char *file_path, std::size_t memory_budget = 0);
+
+  /**
+   * Test if pages are still being read (always true for a stream with a memory budget).
+   */
+  bool is_streaming() const;
+
+  /**
+   * Make the pages read by the background thread since the last call visible, and drop pages if the stream is over
+   * its memory budget. Must be called from the GTK thread.
+   *
+   * @param updated_region Set to the bounding box of the pages that became visible.
+   *
+   * @return true if any page became visible.
+   */
+  bool update_stream(rectangle &updated_region);
+
+private:
+  // Append a primitive and update the bookkeeping shared by all add_ functions
+  void add_primitive(scene_primitive p);
+
+  // Check that primitives can be added, and prepare the arrays to be edited
+  bool prepare_edit();
+
+  // Draw the primitives that intersect a region (in this scene's coordinates). Instances may use the cells of root
+  // below cell_limit, and are drawn from rasters if use_rasters is true.
+  // If id_color is not null, every primitive is drawn in that color. For an ID pass (see draw_ids), id_slots receives
+  // the id of each tagged primitive drawn, and the primitive is drawn in the color encoding its slot. For a style index
+  // pass (see draw_style_indices), palette_base is the position of this scene's styles in the palette.
+  void draw_region(renderer *g,
+      rectangle const &region,
+      scene_transform const *to_target,
+      scene &root,
+      std::size_t cell_limit,
+      bool use_rasters,
+      std::vector<primitive_id> *id_slots = nullptr,
+      color const *id_color = nullptr,
+      std::uint32_t palette_base = NO_PALETTE);
+
+  // Passed as palette_base to draw_region when not drawing style indices
+  static constexpr std::uint32_t NO_PALETTE = UINT32_MAX;
+
+  // Compute the position of each cell's styles in the palette (see palette)
+  void update_palette_offsets();
+
+  // Draw a cell from its cached raster; returns false if the cell is too large to rasterize
+  bool draw_cell_raster(renderer *g, std::uint32_t cell_index, scene_transform const &to_world);
+
+  // Sort the (id, primitive index) pairs of all tagged primitives, for draw_highlight; for a paged or streamed scene,
+  // only those of the pages that are ready
+  void build_id_index();
+
+  // Add the ids of a page to the end of m_id_index
+  void append_page_ids(std::uint32_t page);
+
+  // Merge the ids of a page that became ready into a valid m_id_index
+  void index_page_ids(std::uint32_t page);
+
+  // Find the page that holds a primitive
+  std::uint32_t page_of(std::uint32_t primitive) const;
+
+  // Find the primitive drawn last among those at a point (only tagged ones if tagged_only); cells use the cells of root
+  scene_primitive const *
+  find_topmost(point2d point, double tolerance, scene &root, std::size_t cell_limit, bool tagged_only);
+
+  // Test if a point is on a primitive
+  bool hit_test(scene_primitive const &p, point2d point, double tolerance, scene &root, std::size_t cell_limit);
+
+  // The style table
+  scene_array<scene_style> m_styles;
+
+  // The vertices of all polygons
+  scene_array<point2d> m_points;
+
+  // The primitives, sorted in spatial index order once built
+  scene_array<scene_primitive> m_primitives;
+
+  // The R-tree nodes, level by level starting with the leaves; the root is the last node
+  scene_array<scene_node> m_nodes;
+
+  // The placements of instances
+  scene_array<scene_transform> m_transforms;
+
+  // The bounding box of all primitives
+  rectangle m_bounds;
+
+  // The next insertion order number
+  std::uint32_t m_next_order = 0;
+
+  // True if primitives were added since the index was built
+  bool m_dirty = false;
+
+  // The file the arrays refer to, if the scene was loaded
+  std::unique_ptr<mapped_file> m_file;
+
+  // The pages of the file the scene was loaded or streamed from (empty for scenes built in memory)
+  std::vector<scene_page> m_pages;
+
+  // The level and index of the first node that is a page
+  std::uint32_t m_page_level = 0;
+  std::uint32_t m_first_page_node = 0;
+
+  // The state of each page: PAGE_READY if it can be read; empty if all primitives are in memory and validated
+  std::vector<std::uint8_t> m_page_resident;
+
+  // Page states
+  static constexpr std::uint8_t PAGE_UNCHECKED = 0;
+  static constexpr std::uint8_t PAGE_READY = 1;
+  static constexpr std::uint8_t PAGE_CORRUPT = 2;
+
+  // The background reader, while streaming
+  std::unique_ptr<scene_stream_reader> m_stream;
+
+  // True once a stream without a memory budget has handed over every page, though some could not be used
+  bool m_stream_done = false;
+
+  // The region the stream was last asked to prioritize
+  rectangle m_stream_focus;
+
+  // Tell the stream which pages are needed to draw a region
+  void focus_stream(rectangle const &region);
+
+  // The pages of a paged scene that were recently used, keyed and valued by page number
+  std::unique_ptr<lru_cache<std::uint32_t, std::uint32_t>> m_page_cache;
+
+  // The visible world of the previous draw of a paged scene, to predict where the view is going
+  rectangle m_last_view;
+
+  // Map a scene file; only the index above its pages is validated until they are used
+  bool open_file(const char *file_path);
+
+  // Use a file image written by write_image in place (the image of a file, or of a cell within it)
+  bool map_image(unsigned char const *data, std::size_t size, const char *file_path);
+
+  // Use the cell images of a file image in place
+  bool map_cells(unsigned char const *data, std::size_t size, scene_file_header const &header, const char *file_path);
+
+  // Compute the header (with offsets relative to the start of the image) and page table of the scene's file image;
+  // returns the size of the image
+  std::uint64_t layout_image(scene_file_header &header, std::vector<scene_page> &pages);
+
+  // Write the file image of the scene at the current position of a file
+  bool write_image(std::FILE *file);
+
+  // Request the pages of a paged scene that intersect a region, and validate the pages of a loaded or paged file that
+  // are used for the first time
+  void require_pages(rectangle const &region);
+
+  // Validate a page and mark it ready or corrupt
+  void check_page(std::uint32_t page);
+
+  // Validate every page of a loaded or paged file not checked yet; returns false if a page cannot be used
+  bool check_all_pages();
+
+  // Check the index and primitives below a page of a loaded, paged or streamed scene; returns false if they are corrupt
+  bool validate_page(std::uint32_t page);
+
+  // Ask the system to read the pages of a paged scene around the visible world ahead of time
+  void prefetch_pages(rectangle const &visible);
+
+  // Steer the stream reader toward a view about to be drawn, and prefetch the pages of a paged scene around it
+  void prepare_view(rectangle const &visible);
+
+  // Tell the system whether a page of a paged scene will be needed soon; returns the bytes the page spans
+  std::size_t advise_page(std::uint32_t page, bool needed);
+
+  // Call visit(page) for every page that intersects a region
+  template <typename Visitor>
+  void visit_pages(rectangle const &region, Visitor &&visit);
+
+  // The cells of a top-level scene; declared after m_file because cells loaded from a file refer to its memory
+  std::vector<std::unique_ptr<scene>> m_cells;
+
+  // For a cell, the top-level scene that owns it and the cell's index
+  scene *m_owner = nullptr;
+  std::uint32_t m_cell_index = 0;
+
+  // True if a cell has been placed, after which its bounds must not change
+  bool m_instanced = false;
+
+  // The largest on-screen area of a cell that is drawn from a raster (0 to disable), and the rasters
+  std::size_t m_raster_limit = 0;
+  std::unique_ptr<cell_raster_cache> m_raster_cache;
+
+  // For a top-level scene, the position in the palette of the styles of each cell
+  std::vector<std::uint32_t> m_palette_offsets;
+
+  // Occlusion culling, its coverage mask (reused between draws) and what it saved in the last draw
+  bool m_occlusion_culling = false;
+  std::vector<std::uint8_t> m_occlusion_mask;
+  scene_occlusion_stats m_occlusion_stats;
+
+  // Remove the primitives of m_visible (in drawing order) that are hidden under opaque rectangles
+  void cull_occluded(renderer *g, rectangle const &region);
+
+  // The (id, primitive index) pairs of all tagged primitives, sorted; valid only if m_id_index_valid
+  std::vector<std::pair<primitive_id, std::uint32_t>> m_id_index;
+  bool m_id_index_valid = false;
+
+  // For a paged or streamed scene, whether the ids of each page are in m_id_index
+  std::vector<std::uint8_t> m_id_indexed_pages;
+
+  // Reused between draws to sort visible primitives into drawing order
+  std::vector<std::uint32_t> m_visible;
+
+  // Reused between draws to pass polygon vertices to the renderer
+  std::vector<point2d> m_poly_points;
+};
+
+template <typename Visitor>
+void scene::query(rectangle const &region, Visitor &&visit)
+{
+  if(m_dirty)
+    build();
+
+  if(m_nodes.empty())
+    return;
+
+  // The pages of a loaded file are checked the first time they are used, and a paged scene also reads them
+  if(m_page_cache || (!m_page_resident.empty() && !m_stream))
+    require_pages(region);
+
+  // Depth-first traversal from the root, which is the last node
+  std::uint32_t stack[64 * SCENE_NODE_CAPACITY];
+  std::size_t top = 0;
+  stack[top++] = static_cast<std::uint32_t>(m_nodes.size() - 1);
+
+  while(top > 0) {
+    std::uint32_t index = stack[--top];
+    scene_node const &node = m_nodes[index];
+
+    if(!node.intersects(region))
+      continue;
+
+    // Skip pages that cannot be read yet
+    if(!m_page_resident.empty() && node.level == m_page_level) {
+      std::uint32_t page = index - m_first_page_node;
+      if(page >= m_page_resident.size() || m_page_resident[page] != PAGE_READY)
+        continue;
+    }
+
+    if(node.level == 0) {
+      for(std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+        scene_primitive const &p = m_primitives[i];
+
+        if(std::max(p.x0, p.x1) < region.left() || std::min(p.x0, p.x1) > region.right() ||
+            std::max(p.y0, p.y1) < region.bottom() || std::min(p.y0, p.y1) > region.top())
+          continue;
+
+        visit(p);
+      }
+    } else {
+      for(std::uint32_t i = node.first; i < node.first + node.count; ++i)
+        stack[top++] = i;
+    }
+  }
+}
+}
+
+#endif //EZGL_SCENE_HPP
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_SERIES_HPP
+#define EZGL_SERIES_HPP
+
+#include "ezgl/graphics.hpp"
+#include "ezgl/rectangle.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * The number of blocks of a level of a series aggregated into one block of the next level.
+ */
+constexpr std::size_t SERIES_FANOUT = 16;
+
+/**
+ * A time series (e.g., a solver's convergence or a power trace) that can be plotted quickly however many samples it has.
+ *
+ * Drawing a series with one draw_line per pair of samples costs as much as the series is long, although at most a few
+ * samples per pixel column can be seen. A series instead draws, for each pixel column, a line to the first sample of
+ * the column, a vertical line between the smallest and largest samples, and ends at the last sample (M4 decimation),
+ * which is the same picture with at most two line segments per column.
+ *
+ * The minimum and maximum of blocks of SERIES_FANOUT samples, of SERIES_FANOUT blocks, and so on, are computed when the
+ * samples are set. Drawing takes a whole block whenever it falls in a single pixel column, so each frame reads
+ * O(pixel columns * log(samples)) data, regardless of how many samples are visible.
+ */
+class series {
+public:
+  /**
+   * Create an empty series.
+   */
+  series() = default;
+
+  /**
+   * Create a series from samples.
+   *
+   * @see assign
+   */
+  series(double const *x, double const *y, std::size_t count);
+
+  /**
+   * Replace the samples.
+   *
+   * @param x The x coordinate of each sample, in world coordinates. They must not decrease.
+   * @param y The y coordinate of each sample, in world coordinates.
+   * @param count The number of samples.
+   *
+   * @return false if the x coordinates decrease, in which case the series is left empty.
+   */
+  bool assign(double const *x, double const *y, std::size_t count);
+
+  /**
+   * The number of samples.
+   */
+  std::size_t size() const
+  {
+    return m_x.size();
+  }
+
+  /**
+   * The smallest rectangle that contains all samples.
+   */
+  rectangle bounds() const
+  {
+    return m_bounds;
+  }
+
+  /**
+   * Draw the series as a line through its samples, in the current color and line width.
+   *
+   * @param g The renderer to draw with. Its coordinate system is set to world coordinates.
+   */
+  void draw(renderer *g);
+
+private:
+  struct extent {
+    double min, max;
+  };
+
+  // Accumulates the samples of a pixel column and adds its segments
+  struct column_state;
+
+  // Take the samples [first, last) into the column they are in
+  void add_block(column_state &column, std::size_t first, std::size_t last, extent const &e);
+
+  // Add the segments of a finished column
+  void finish_column(column_state &column);
+
+  // The samples
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  rectangle m_bounds;
+
+  // m_levels[k][b] is the extent of samples [b * SERIES_FANOUT^(k + 1), (b + 1) * SERIES_FANOUT^(k + 1))
+  std::vector<std::vector<extent>> m_levels;
+
+  // Reused between draws to pass the segments to the renderer
+  std::vector<line_segment> m_segments;
+};
+}
+
+#endif //EZGL_SERIES_HPP
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_SNAP_REGISTRY_HPP
+#define EZGL_SNAP_REGISTRY_HPP
+
+#include "ezgl/point.hpp"
+#include "ezgl/scene.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * A point the cursor can snap to (e.g., a pin).
+ */
+struct snap_point {
+  /**
+   * The position of the point, in world coordinates.
+   */
+  point2d position;
+
+  /**
+   * A user-defined tag used to identify the point.
+   */
+  primitive_id id;
+};
+
+/**
+ * A set of snap points that can quickly find the point nearest to the cursor.
+ *
+ * The points are stored in a balanced KD-tree (laid out implicitly in a single array, each node splitting the widest
+ * dimension of its points at the median), so a nearest point search takes O(log n) time and is fast enough to run on
+ * every mouse motion event, even with millions of points.
+ *
+ * Points added after the tree is built are searched linearly until there are enough of them to be worth a rebuild,
+ * which happens automatically on the next search.
+ *
+ * Each canvas owns a snap_registry (see canvas::get_snap_points) that canvas::nearest searches.
+ */
+class snap_registry {
+public:
+  /**
+   * Reserve memory for a number of points.
+   */
+  void reserve(std::size_t count)
+  {
+    m_points.reserve(count);
+  }
+
+  /**
+   * Add a point.
+   *
+   * @param position The position of the point, in world coordinates.
+   * @param id (optional) A tag used to identify the point.
+   */
+  void add(point2d position, primitive_id id = 0)
+  {
+    m_points.push_back({position, id});
+  }
+
+  /**
+   * The number of points.
+   */
+  std::size_t size() const
+  {
+    return m_points.size();
+  }
+
+  /**
+   * Remove all points.
+   */
+  void clear();
+
+  /**
+   * Build the KD-tree from all points.
+   *
+   * Called automatically when many points were added since the last build; call it explicitly after adding points in
+   * bulk to control when the cost is paid. Building reorders the points.
+   */
+  void build();
+
+  /**
+   * Find the point nearest to a position.
+   *
+   * @param position The position, in world coordinates.
+   * @param max_distance The largest distance to search, in world coordinates.
+   *
+   * @return The nearest point, or nullptr if there is no point within max_distance. The pointer is valid until
+   *         points are added.
+   */
+  snap_point const *nearest(point2d position, double max_distance);
+
+private:
+  // Build the subtree of the points [first, last)
+  void build(std::size_t first, std::size_t last);
+
+  // Search the subtree of the points [first, last), updating the best point and its squared distance
+  void search(std::size_t first,
+      std::size_t last,
+      point2d position,
+      snap_point const *&best,
+      double &best_distance) const;
+
+  // The points; the first m_built form the tree, the others were added since
+  std::vector<snap_point> m_points;
+  std::size_t m_built = 0;
+
+  // The dimension (0 for x, 1 for y) each node of the tree splits
+  std::vector<std::uint8_t> m_axes;
+};
+}
+
+#endif //EZGL_SNAP_REGISTRY_HPP
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_TILE_GRID_HPP
+#define EZGL_TILE_GRID_HPP
+
+#include "ezgl/color.hpp"
+#include "ezgl/point.hpp"
+#include "ezgl/rectangle.hpp"
+#include "ezgl/scene.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ezgl {
+
+class renderer;
+
+/**
+ * A retained collection of primitives for drawings that are regular arrays of tiles (e.g., the tiles of an FPGA).
+ *
+ * Each primitive belongs to a tile, given by its integer (column, row) coordinates. The primitives of each tile are
+ * stored contiguously, tiles in row-major order, so the primitives of a row of tiles form a single range. Drawing finds
+ * the visible tiles from the visible world with a division per edge and walks one range per visible row: culling costs
+ * nothing per primitive and there is no tree to build or search.
+ *
+ * Primitives may extend outside of their tile; the visible range is grown by the largest such overhang.
+ *
+ * Use a scene instead for drawings that are not regular grids.
+ */
+class tile_grid {
+public:
+  /**
+   * Create an empty grid.
+   *
+   * @param origin The bottom-left corner of tile (0, 0), in world coordinates.
+   * @param tile_width The width of a tile, in world coordinates.
+   * @param tile_height The height of a tile, in world coordinates.
+   * @param columns The number of columns of tiles.
+   * @param rows The number of rows of tiles.
+   */
+  tile_grid(point2d origin, double tile_width, double tile_height, int columns, int rows);
+
+  /**
+   * The number of columns of tiles.
+   */
+  int columns() const
+  {
+    return m_columns;
+  }
+
+  /**
+   * The number of rows of tiles.
+   */
+  int rows() const
+  {
+    return m_rows;
+  }
+
+  /**
+   * The area covered by a tile, in world coordinates.
+   */
+  rectangle tile_bounds(int column, int row) const
+  {
+    point2d corner = {m_origin.x + column * m_tile_width, m_origin.y + row * m_tile_height};
+
+    return {corner, m_tile_width, m_tile_height};
+  }
+
+  /**
+   * Find the tile that contains a point.
+   *
+   * @param point The point, in world coordinates.
+   * @param column Set to the column of the tile.
+   * @param row Set to the row of the tile.
+   *
+   * @return false if the point is outside of the grid.
+   */
+  bool tile_at(point2d point, int &column, int &row) const;
+
+  /**
+   * Add a style to the style table.
+   *
+   * @see scene::add_style
+   */
+  std::uint32_t add_style(color c, int line_width = 0);
+
+  /**
+   * Add a filled rectangle to a tile.
+   *
+   * @param column The column of the tile.
+   * @param row The row of the tile.
+   * @param r The rectangle, in world coordinates.
+   * @param style The index of the style returned by add_style.
+   * @param id (optional) A tag used to identify the primitive.
+   * @param layer (optional) The layer of the primitive. Lower layers are drawn first.
+   */
+  void add_fill_rectangle(int column,
+      int row,
+      rectangle r,
+      std::uint32_t style,
+      primitive_id id = 0,
+      std::uint8_t layer = 0);
+
+  /**
+   * Add the outline of a rectangle to a tile.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_rectangle(int column, int row, rectangle r, std::uint32_t style, primitive_id id = 0, std::uint8_t layer = 0);
+
+  /**
+   * Add a line segment to a tile.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_line(int column,
+      int row,
+      point2d start,
+      point2d end,
+      std::uint32_t style,
+      primitive_id id = 0,
+      std::uint8_t layer = 0);
+
+  /**
+   * Add a filled polygon to a tile.
+   *
+   * @param points The vertices of the polygon, in world coordinates. There must be at least 2 points.
+   *
+   * @see add_fill_rectangle
+   */
+  void add_fill_poly(int column,
+      int row,
+      std::vector<point2d> const &points,
+      std::uint32_t style,
+      primitive_id id = 0,
+      std::uint8_t layer = 0);
+
+  /**
+   * Remove all primitives and styles.
+   */
+  void clear();
+
+  /**
+   * The number of primitives.
+   */
+  std::size_t size() const
+  {
+    return m_primitives.size();
+  }
+
+  /**
+   * Sort the primitives by tile.
+   *
+   * Called automatically before drawing or querying a grid that has been modified.
+   */
+  void build();
+
+  /**
+   * Visit every primitive whose bounding box intersects a region.
+   *
+   * @param region The region, in world coordinates.
+   * @param visit A function called as visit(scene_primitive const &) for each primitive, in drawing order.
+   */
+  template <typename Visitor>
+  void query(rectangle const &region, Visitor &&visit);
+
+  /**
+   * Draw the primitives of the tiles that intersect the renderer's visible world, in layer order.
+   *
+   * Within a layer, the primitives of a tile are drawn in insertion order, and tiles in row-major order.
+   *
+   * @param g The renderer to draw with. Its color and line width are changed.
+   */
+  void draw(renderer *g);
+
+private:
+  // Find the range of tiles whose primitives may intersect a region; returns false if there are none
+  bool tile_range(rectangle const &region, int &first_column, int &last_column, int &first_row, int &last_row) const;
+
+  // Call visit(first, last) for each range of primitives of a row of tiles intersecting a region, in drawing order
+  template <typename Visitor>
+  void visit_ranges(rectangle const &region, Visitor &&visit);
+
+  // Add a primitive to a tile
+  void add_primitive(int column, int row, scene_primitive p);
+
+  // The geometry of the grid
+  point2d m_origin;
+  double m_tile_width;
+  double m_tile_height;
+  int m_columns;
+  int m_rows;
+
+  // The style table
+  std::vector<scene_style> m_styles;
+
+  // The vertices of all polygons
+  std::vector<point2d> m_points;
+
+  // The primitives, sorted by layer, then tile, then insertion order once built, and the tile of each primitive
+  std::vector<scene_primitive> m_primitives;
+  std::vector<std::uint32_t> m_tiles;
+
+  // The layers that have primitives, in drawing order
+  std::vector<std::uint8_t> m_layers;
+
+  // The primitives of tile t of the i-th layer are [m_tile_start[i * tiles + t], m_tile_start[i * tiles + t + 1])
+  std::vector<std::uint32_t> m_tile_start;
+
+  // How far any primitive extends outside of its tile, in world coordinates
+  double m_overhang_x = 0;
+  double m_overhang_y = 0;
+
+  // True if primitives were added since the grid was built
+  bool m_dirty = false;
+
+  // Reused between draws to pass polygon vertices to the renderer
+  std::vector<point2d> m_poly_points;
+};
+
+template <typename Visitor>
+void tile_grid::visit_ranges(rectangle const &region, Visitor &&visit)
+{
+  if(m_dirty)
+    build();
+
+  int first_column, last_column, first_row, last_row;
+  if(m_primitives.empty() || !tile_range(region, first_column, last_column, first_row, last_row))
+    return;
+
+  std::size_t tiles = static_cast<std::size_t>(m_columns) * m_rows;
+
+  for(std::size_t layer = 0; layer < m_layers.size(); ++layer) {
+    for(int row = first_row; row <= last_row; ++row) {
+      std::size_t first_tile = layer * tiles + static_cast<std::size_t>(row) * m_columns + first_column;
+      std::size_t last_tile = layer * tiles + static_cast<std::size_t>(row) * m_columns + last_column;
+
+      if(m_tile_start[first_tile] != m_tile_start[last_tile + 1])
+        visit(m_tile_start[first_tile], m_tile_start[last_tile + 1]);
+    }
+  }
+}
+
+template <typename Visitor>
+void tile_grid::query(rectangle const &region, Visitor &&visit)
+{
+  visit_ranges(region, [&](std::uint32_t first, std::uint32_t last) {
+    for(std::uint32_t i = first; i < last; ++i) {
+      scene_primitive const &p = m_primitives[i];
+
+      if(std::max(p.x0, p.x1) < region.left() || std::min(p.x0, p.x1) > region.right() ||
+          std::max(p.y0, p.y1) < region.bottom() || std::min(p.y0, p.y1) > region.top())
+        continue;
+
+      visit(p);
+    }
+  });
+}
+}
+
+#endif //EZGL_TILE_GRID_HPP
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#ifndef EZGL_TIMELINE_HPP
+#define EZGL_TIMELINE_HPP
+
+#include "ezgl/color.hpp"
+#include "ezgl/graphics.hpp"
+#include "ezgl/rectangle.hpp"
+#include "ezgl/scene.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ezgl {
+
+/**
+ * The number of intervals of a row of a timeline summarized by one entry of its skip structure.
+ */
+constexpr std::size_t TIMELINE_BLOCK = 64;
+
+/**
+ * An interval of a timeline.
+ */
+struct timeline_interval {
+  /**
+   * The start and end of the interval, in world x coordinates.
+   */
+  double start, end;
+
+  /**
+   * The color of the interval.
+   */
+  packed_color color;
+
+  /**
+   * A tag used to identify the interval.
+   */
+  primitive_id id;
+};
+
+/**
+ * Intervals on a horizontal timeline (e.g., signal transitions or task spans), in rows, for viewers of millions of
+ * intervals.
+ *
+ * The intervals of each row are sorted by start. For each block of TIMELINE_BLOCK intervals, the row keeps the largest
+ * end in the block and in all blocks up to it, so a query binary-searches the first block that can reach the region,
+ * skips the blocks that end before it, and stops at the first interval that starts after it: only intervals near the
+ * visible x range are visited, and rows outside the visible y range are not visited at all.
+ *
+ * When zoomed out, many intervals share a pixel. Drawing merges the visible intervals of a row into runs of whole
+ * pixels: intervals of the same color that touch extend the current run, and intervals hidden in pixels already drawn
+ * are skipped, so the number of rectangles drawn per row is at most the number of pixel columns.
+ *
+ * Row r covers world y coordinates [r * row_height, (r + 1) * row_height).
+ */
+class timeline {
+public:
+  /**
+   * Create an empty timeline.
+   *
+   * @param row_height The height of a row, in world coordinates.
+   * @param row_fill The fraction of the height of a row covered by its intervals, leaving a gap between rows.
+   */
+  explicit timeline(double row_height = 1, double row_fill = 0.8);
+
+  /**
+   * Add an interval.
+   *
+   * @param row The row of the interval.
+   * @param start The start of the interval, in world x coordinates.
+   * @param end The end of the interval. Swapped with start if smaller.
+   * @param c The color of the interval.
+   * @param id (optional) A tag used to identify the interval.
+   */
+  void add(std::uint32_t row, double start, double end, packed_color c, primitive_id id = 0);
+
+  /**
+   * Remove all intervals.
+   */
+  void clear();
+
+  /**
+   * The number of intervals.
+   */
+  std::size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * The number of rows (one more than the largest row that has an interval).
+   */
+  std::size_t rows() const
+  {
+    return m_rows.size();
+  }
+
+  /**
+   * The smallest rectangle that contains all intervals.
+   */
+  rectangle bounds() const;
+
+  /**
+   * Sort the intervals and build the skip structure.
+   *
+   * Called automatically before drawing or querying a timeline that has been modified.
+   */
+  void build();
+
+  /**
+   * Visit every interval that intersects a region.
+   *
+   * @param region The region, in world coordinates.
+   * @param visit A function called as visit(std::uint32_t row, timeline_interval const &) for each interval, by row
+   *              and then by start.
+   */
+  template <typename Visitor>
+  void query(rectangle const &region, Visitor &&visit);
+
+  /**
+   * Draw the intervals that intersect the renderer's visible world, merged into runs of whole pixels.
+   *
+   * @param g The renderer to draw with. Its coordinate system is set to world coordinates.
+   */
+  void draw(renderer *g);
+
+private:
+  struct row {
+    // The intervals, sorted by start once built
+    std::vector<timeline_interval> intervals;
+
+    // For each block of TIMELINE_BLOCK intervals, the largest end in the block, and in the block and all before it
+    std::vector<double> block_end;
+    std::vector<double> prefix_end;
+
+    // True if intervals were added since the row was built
+    bool dirty = false;
+  };
+
+  // The range of rows that intersect a region; returns false if there are none
+  bool row_range(rectangle const &region, std::size_t &first, std::size_t &last) const;
+
+  // Call visit(interval) for each interval of a row that intersects [from, to], by start
+  template <typename Visitor>
+  void visit_row(row const &r, double from, double to, Visitor &&visit) const;
+
+  double m_row_height;
+  double m_row_fill;
+
+  std::vector<row> m_rows;
+  std::size_t m_size = 0;
+
+  // The smallest start and largest end of all intervals
+  double m_start = 0;
+  double m_end = 0;
+  bool m_dirty = false;
+
+  // Reused between draws to pass the runs to the renderer
+  std::vector<rectangle> m_runs;
+  std::vector<packed_color> m_run_colors;
+};
+
+template <typename Visitor>
+void timeline::visit_row(row const &r, double from, double to, Visitor &&visit) const
+{
+  std::vector<timeline_interval> const &intervals = r.intervals;
+
+  // The intervals that start after the range, and the blocks that all end before it, are not visited
+  auto last = std::upper_bound(intervals.begin(), intervals.end(), to,
+      [](double x, timeline_interval const &i) { return x < i.start; });
+  std::size_t end = last - intervals.begin();
+
+  std::size_t block = std::lower_bound(r.prefix_end.begin(), r.prefix_end.end(), from) - r.prefix_end.begin();
+
+  for(; block * TIMELINE_BLOCK < end; ++block) {
+    if(r.block_end[block] < from)
+      continue;
+
+    std::size_t block_last = std::min(end, (block + 1) * TIMELINE_BLOCK);
+    for(std::size_t i = block * TIMELINE_BLOCK; i < block_last; ++i) {
+      if(intervals[i].end >= from)
+        visit(intervals[i]);
+    }
+  }
+}
+
+template <typename Visitor>
+void timeline::query(rectangle const &region, Visitor &&visit)
+{
+  if(m_dirty)
+    build();
+
+  std::size_t first, last;
+  if(!row_range(region, first, last))
+    return;
+
+  for(std::size_t r = first; r <= last; ++r) {
+    visit_row(m_rows[r], region.left(), region.right(),
+        [&](timeline_interval const &i) { visit(static_cast<std::uint32_t>(r), i); });
+  }
+}
+}
+
+#endif //EZGL_TIMELINE_HPP
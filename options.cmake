@@ -9,3 +9,9 @@ option(
   "Create HTML/PDF documentation (requires Doygen)."
   OFF
 )
+
+option(
+  EZGL_BUILD_TESTS
+  "Build the EZGL tests (run them with ctest)."
+  ${IS_ROOT_PROJECT} #Only build tests by default if EZGL is the root cmake project
+)
@@ -708,6 +708,21 @@ renderer *application::get_renderer()
   return cnv->create_animation_renderer();
 }
 
+cache_manager &application::get_cache_manager()
+{
+  return default_cache_manager();
+}
+
+void application::set_cache_budget(std::size_t bytes)
+{
+  default_cache_manager().set_budget(bytes);
+}
+
+cache_manager_stats application::get_cache_stats() const
+{
+  return default_cache_manager().stats();
+}
+
 void set_disable_event_loop(bool new_setting)
 {
   disable_event_loop = new_setting;
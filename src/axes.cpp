@@ -0,0 +1,205 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/axes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace ezgl {
+
+// More ticks than any view shows; bounds the loops if the view is degenerate
+static constexpr double MAX_TICKS = 10000;
+
+// The number of ticks numbered first to last. Far from the origin first + 1 == first in floating point, so the ticks
+// are counted with an integer rather than stepped through with the double.
+static long long tick_count(double first, double last)
+{
+  double count = last - first + 1;
+  if(!(count >= 1))
+    return 0;
+
+  return static_cast<long long>(std::min(count, MAX_TICKS));
+}
+
+axes::axes()
+    : m_grid_color(0xDD, 0xDD, 0xDD)
+    , m_label_color(BLACK)
+    , m_labels("axis labels", 0.1, eviction_policy::lru, &default_cache_manager(),
+          [](cairo_surface_t *&surface) { cairo_surface_destroy(surface); })
+{
+}
+
+void axes::set_grid_color(color c)
+{
+  m_grid_color = c;
+}
+
+void axes::set_label_color(color c)
+{
+  if(c != m_label_color)
+    m_labels.clear();
+
+  m_label_color = c;
+}
+
+void axes::set_font_size(double size)
+{
+  if(size != m_font_size)
+    m_labels.clear();
+
+  m_font_size = size;
+}
+
+void axes::set_tick_spacing(double pixels)
+{
+  m_tick_spacing = pixels;
+}
+
+double axes::tick_step(double range, double max_ticks)
+{
+  double raw = range / std::max(max_ticks, 1.0);
+  if(!(raw > 0) || !std::isfinite(raw))
+    return 1;
+
+  double magnitude = std::pow(10, std::floor(std::log10(raw)));
+  double normalized = raw / magnitude;
+
+  if(normalized <= 1)
+    return magnitude;
+  if(normalized <= 2)
+    return 2 * magnitude;
+  if(normalized <= 5)
+    return 5 * magnitude;
+
+  return 10 * magnitude;
+}
+
+std::string axes::format_tick(double value, double step)
+{
+  char text[64];
+
+  if(step >= 1e6 || step < 1e-4) {
+    std::snprintf(text, sizeof(text), "%g", value);
+  } else {
+    int decimals = std::max(0, static_cast<int>(-std::floor(std::log10(step) + 1e-9)));
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+  }
+
+  return text;
+}
+
+cairo_surface_t *axes::label(std::string const &text)
+{
+  cairo_surface_t **cached = m_labels.find(text);
+  if(cached != nullptr)
+    return *cached;
+
+  // Measure the text on a scratch surface
+  cairo_surface_t *scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+  cairo_t *context = cairo_create(scratch);
+  cairo_select_font_face(context, "sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(context, m_font_size);
+
+  cairo_text_extents_t text_extents;
+  cairo_font_extents_t font_extents;
+  cairo_text_extents(context, text.c_str(), &text_extents);
+  cairo_font_extents(context, &font_extents);
+
+  cairo_destroy(context);
+  cairo_surface_destroy(scratch);
+
+  int width = static_cast<int>(std::ceil(text_extents.x_advance)) + 2;
+  int height = static_cast<int>(std::ceil(font_extents.ascent + font_extents.descent)) + 2;
+
+  cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  context = cairo_create(surface);
+  cairo_select_font_face(context, "sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(context, m_font_size);
+  cairo_set_source_rgba(context, m_label_color.red / 255.0, m_label_color.green / 255.0, m_label_color.blue / 255.0,
+      m_label_color.alpha / 255.0);
+  cairo_move_to(context, 1, 1 + font_extents.ascent);
+  cairo_show_text(context, text.c_str());
+  cairo_destroy(context);
+  cairo_surface_flush(surface);
+
+  m_labels.insert(text, surface, static_cast<std::size_t>(width) * height * 4);
+
+  return surface;
+}
+
+void axes::draw(renderer *g)
+{
+  g->set_coordinate_system(WORLD);
+
+  rectangle world = g->get_visible_world();
+  rectangle screen = g->get_visible_screen();
+
+  if(!(world.width() > 0) || !(world.height() > 0))
+    return;
+
+  double x_step = tick_step(world.width(), screen.width() / m_tick_spacing);
+  double y_step = tick_step(world.height(), screen.height() / m_tick_spacing);
+
+  // Ticks are numbered from 0 so their positions do not drift as the view pans
+  double first_x = std::ceil(world.left() / x_step);
+  double last_x = std::floor(world.right() / x_step);
+  double first_y = std::ceil(world.bottom() / y_step);
+  double last_y = std::floor(world.top() / y_step);
+  long long x_count = tick_count(first_x, last_x);
+  long long y_count = tick_count(first_y, last_y);
+
+  m_grid.clear();
+  for(long long i = 0; i < x_count; ++i)
+    m_grid.push_back({{(first_x + i) * x_step, world.bottom()}, {(first_x + i) * x_step, world.top()}});
+  for(long long i = 0; i < y_count; ++i)
+    m_grid.push_back({{world.left(), (first_y + i) * y_step}, {world.right(), (first_y + i) * y_step}});
+
+  g->set_color(m_grid_color);
+  g->set_line_width(0);
+  g->draw_lines(m_grid);
+
+  // The labels are placed in pixels, along the bottom and left edges; screen y grows downwards, so the bottom edge is
+  // at the largest y
+  g->set_coordinate_system(SCREEN);
+
+  double bottom_edge = screen.top();
+
+  auto screen_x = [&](double x) {
+    return screen.left() + (x - world.left()) / world.width() * screen.width();
+  };
+  auto screen_y = [&](double y) {
+    return bottom_edge - (y - world.bottom()) / world.height() * screen.height();
+  };
+
+  g->set_horiz_justification(justification::center);
+  g->set_vert_justification(justification::bottom);
+  for(long long i = 0; i < x_count; ++i) {
+    double k = first_x + i;
+    g->draw_surface(label(format_tick(k == 0 ? 0 : k * x_step, x_step)), {screen_x(k * x_step), bottom_edge - 2});
+  }
+
+  g->set_horiz_justification(justification::left);
+  g->set_vert_justification(justification::center);
+  for(long long i = 0; i < y_count; ++i) {
+    double k = first_y + i;
+    g->draw_surface(label(format_tick(k == 0 ? 0 : k * y_step, y_step)), {screen.left() + 2, screen_y(k * y_step)});
+  }
+}
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/cache.hpp"
+
+#include <algorithm>
+
+namespace ezgl {
+
+cache_base::cache_base(std::string name, double weight, cache_manager *manager)
+    : m_name(std::move(name)), m_weight(weight > 0 ? weight : 1.0), m_manager(manager)
+{
+  if(m_manager != nullptr)
+    m_manager->attach(this);
+}
+
+cache_base::~cache_base()
+{
+  if(m_manager != nullptr)
+    m_manager->detach(this);
+}
+
+void cache_base::set_weight(double new_weight)
+{
+  if(new_weight > 0)
+    m_weight = new_weight;
+
+  if(m_manager != nullptr)
+    m_manager->trim();
+}
+
+cache_stats cache_base::stats() const
+{
+  cache_stats s;
+  s.name = m_name;
+  s.bytes = m_bytes;
+  s.entries = size();
+  s.weight = m_weight;
+  s.hits = m_hits;
+  s.misses = m_misses;
+  s.evictions = m_evictions;
+
+  return s;
+}
+
+void cache_base::charge(std::size_t added_bytes)
+{
+  m_bytes += added_bytes;
+
+  if(m_manager != nullptr) {
+    m_manager->m_bytes += added_bytes;
+    m_manager->trim();
+  }
+}
+
+void cache_base::release(std::size_t removed_bytes, bool evicted)
+{
+  m_bytes -= removed_bytes;
+
+  if(evicted)
+    ++m_evictions;
+
+  if(m_manager != nullptr)
+    m_manager->m_bytes -= removed_bytes;
+}
+
+cache_manager::cache_manager(std::size_t budget) : m_budget(budget)
+{
+}
+
+cache_manager::~cache_manager()
+{
+  for(cache_base *cache : m_caches)
+    cache->m_manager = nullptr;
+}
+
+void cache_manager::attach(cache_base *cache)
+{
+  m_caches.push_back(cache);
+  m_bytes += cache->m_bytes;
+}
+
+void cache_manager::detach(cache_base *cache)
+{
+  m_caches.erase(std::remove(m_caches.begin(), m_caches.end(), cache), m_caches.end());
+  m_bytes -= cache->m_bytes;
+}
+
+void cache_manager::set_budget(std::size_t new_budget)
+{
+  m_budget = new_budget;
+  trim();
+}
+
+void cache_manager::trim()
+{
+  // Evicting from a cache releases bytes but never charges new ones, so nested calls have nothing to do
+  if(m_trimming)
+    return;
+
+  m_trimming = true;
+
+  while(m_bytes > m_budget) {
+    double total_weight = 0;
+    for(cache_base *cache : m_caches)
+      total_weight += cache->m_weight;
+
+    // Pick the cache that exceeds its weighted share of the budget by the largest amount
+    cache_base *victim = nullptr;
+    double largest_excess = 0;
+    for(cache_base *cache : m_caches) {
+      double share = m_budget * (cache->m_weight / total_weight);
+      double excess = cache->m_bytes - share;
+
+      if(cache->size() > 1 && (victim == nullptr || excess > largest_excess)) {
+        victim = cache;
+        largest_excess = excess;
+      }
+    }
+
+    // Every cache is down to its most recent entry
+    if(victim == nullptr)
+      break;
+
+    std::size_t overflow = m_bytes - m_budget;
+    std::size_t target = largest_excess > 0 ? std::min<std::size_t>(overflow, largest_excess) : overflow;
+
+    if(victim->evict(std::max<std::size_t>(target, 1)) == 0)
+      break;
+  }
+
+  m_trimming = false;
+}
+
+void cache_manager::clear()
+{
+  for(cache_base *cache : m_caches)
+    cache->clear();
+}
+
+cache_manager_stats cache_manager::stats() const
+{
+  cache_manager_stats s;
+  s.budget = m_budget;
+  s.bytes = m_bytes;
+
+  for(cache_base const *cache : m_caches) {
+    s.caches.push_back(cache->stats());
+    s.hits += cache->m_hits;
+    s.misses += cache->m_misses;
+    s.evictions += cache->m_evictions;
+  }
+
+  return s;
+}
+
+cache_manager &default_cache_manager()
+{
+  static cache_manager manager;
+
+  return manager;
+}
+}
@@ -18,6 +18,9 @@
 
 #include "ezgl/callback.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace ezgl {
 
 /**
@@ -47,6 +50,35 @@ struct mouse_pan {
   bool has_panned = false; 
 } g_mouse_pan;
 
+/**
+ * Tracks a rubber-band selection (a drag with the panning mouse button while Shift is held).
+ */
+struct box_select {
+  /**
+   * Tracks whether a selection box is being dragged
+   */
+  bool active = false;
+  /**
+   * The position of the mouse pointer where the drag started, in widget coordinates
+   */
+  double start_x = 0;
+  double start_y = 0;
+  /**
+   * Whether the pointer has moved far enough from the start to be a drag; otherwise the release is a Shift+click
+   */
+  bool dragged = false;
+} g_box_select;
+
+// How far the pointer must move, in pixels, before a Shift+click becomes a selection drag
+static constexpr double BOX_SELECT_THRESHOLD = 4;
+
+// The rectangle between the start of a selection drag and the mouse pointer, in widget coordinates
+static rectangle selection_box(double x, double y)
+{
+  return {{std::min(g_box_select.start_x, x), std::min(g_box_select.start_y, y)},
+      {std::max(g_box_select.start_x, x), std::max(g_box_select.start_y, y)}};
+}
+
 gboolean press_key(GtkWidget *, GdkEventKey *event, gpointer data)
 {
   auto application = static_cast<ezgl::application *>(data);
@@ -72,8 +104,16 @@ gboolean press_mouse(GtkWidget *, GdkEventButton *event, gpointer data)
 
   if(event->type == GDK_BUTTON_PRESS) {
 
+    // Shift + drag selects a region instead of panning
+    if(event->button == PANNING_MOUSE_BUTTON && (event->state & GDK_SHIFT_MASK) != 0 &&
+        application->box_select_callback != nullptr) {
+      g_box_select.active = true;
+      g_box_select.dragged = false;
+      g_box_select.start_x = event->x;
+      g_box_select.start_y = event->y;
+    }
     // Check for mouse press to support dragging. 
-    if(event->button == PANNING_MOUSE_BUTTON) {
+    else if(event->button == PANNING_MOUSE_BUTTON) {
       g_mouse_pan.panning_mouse_button_pressed = true;
       g_mouse_pan.prev_x = event->x;
       g_mouse_pan.prev_y = event->y;
@@ -102,8 +142,26 @@ gboolean release_mouse(GtkWidget *, GdkEventButton *event, gpointer data)
   auto application = static_cast<ezgl::application *>(data);
 
   if(event->type == GDK_BUTTON_RELEASE) {
-    // Check for mouse release to support dragging
-    if(event->button == PANNING_MOUSE_BUTTON) {
+    // Finish a selection: only the overlay is cleared, the canvas is not redrawn
+    if(event->button == PANNING_MOUSE_BUTTON && g_box_select.active && g_box_select.dragged) {
+      g_box_select.active = false;
+
+      std::string main_canvas_id = application->get_main_canvas_id();
+      ezgl::canvas *canvas = application->get_canvas(main_canvas_id);
+      canvas->clear_selection_box();
+
+      rectangle const box = selection_box(event->x, event->y);
+      ezgl::point2d const first = canvas->get_camera().widget_to_world(box.bottom_left());
+      ezgl::point2d const second = canvas->get_camera().widget_to_world(box.top_right());
+      rectangle const world = {{std::min(first.x, second.x), std::min(first.y, second.y)},
+          {std::max(first.x, second.x), std::max(first.y, second.y)}};
+
+      if(application->box_select_callback != nullptr)
+        application->box_select_callback(application, world, canvas->select(world));
+    }
+    // Check for mouse release to support dragging. A Shift+click that did not drag a selection box is a click.
+    else if(event->button == PANNING_MOUSE_BUTTON) {
+      g_box_select.active = false;
       g_mouse_pan.panning_mouse_button_pressed = false;
 
       // Call the user-defined mouse press callback for the PANNING_MOUSE_BUTTON button only if no panning occurs. 
@@ -131,8 +189,20 @@ gboolean move_mouse(GtkWidget *, GdkEventButton *event, gpointer data)
 
   if(event->type == GDK_MOTION_NOTIFY) {
 
+    // Move the rubber band of a selection, drawn over the canvas without redrawing it
+    if(g_box_select.active) {
+      if(std::hypot(event->x - g_box_select.start_x, event->y - g_box_select.start_y) > BOX_SELECT_THRESHOLD)
+        g_box_select.dragged = true;
+
+      if(g_box_select.dragged) {
+        std::string main_canvas_id = application->get_main_canvas_id();
+        ezgl::canvas *canvas = application->get_canvas(main_canvas_id);
+
+        canvas->set_selection_box(selection_box(event->x, event->y));
+      }
+    }
     // Check if the mouse button is pressed to support dragging
-    if(g_mouse_pan.panning_mouse_button_pressed) {
+    else if(g_mouse_pan.panning_mouse_button_pressed) {
       // Code below drops a panning event if we served anothe one 
       // less than 100 ms. I believe it was intended to avoid having panning
       // fall behind and queue up many events if redraws were slow. However,
@@ -22,13 +22,14 @@
 
 #include <gtk/gtk.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <functional>
 
 namespace ezgl {
 
-static cairo_surface_t *create_surface(GtkWidget *widget)
+static cairo_surface_t *create_surface(GtkWidget *widget, render_backend backend)
 {
   GdkWindow *parent_window = gtk_widget_get_window(widget);
   int const width = gtk_widget_get_allocated_width(widget);
@@ -37,9 +38,13 @@ static cairo_surface_t *create_surface(GtkWidget *widget)
   // Cairo image surfaces are more efficient than normal Cairo surfaces
   // However, you cannot use X11 functions to draw on image surfaces
 #ifdef EZGL_USE_X11
-  cairo_surface_t *p_surface = gdk_window_create_similar_surface(
-      parent_window, CAIRO_CONTENT_COLOR_ALPHA, width, height);
+  cairo_surface_t *p_surface;
+  if(backend == render_backend::cairo_image)
+    p_surface = gdk_window_create_similar_image_surface(parent_window, CAIRO_FORMAT_ARGB32, width, height, 0);
+  else
+    p_surface = gdk_window_create_similar_surface(parent_window, CAIRO_CONTENT_COLOR_ALPHA, width, height);
 #else
+  (void)backend;
   cairo_surface_t *p_surface = gdk_window_create_similar_image_surface(
       parent_window, CAIRO_FORMAT_ARGB32, width, height, 0);
 #endif
@@ -93,6 +98,7 @@ bool canvas::print_pdf(const char *file_name, int output_width, int output_heigh
   using namespace std::placeholders;
   camera pdf_cam = m_camera;
   pdf_cam.update_widget(surface_width, surface_height);
+  draw_scene(context, &pdf_cam, pdf_surface);
   renderer g(context, std::bind(&camera::world_to_screen, pdf_cam, _1), &pdf_cam, pdf_surface);
   m_draw_callback(&g);
 
@@ -132,6 +138,7 @@ bool canvas::print_svg(const char *file_name, int output_width, int output_heigh
   using namespace std::placeholders;
   camera svg_cam = m_camera;
   svg_cam.update_widget(surface_width, surface_height);
+  draw_scene(context, &svg_cam, svg_surface);
   renderer g(context, std::bind(&camera::world_to_screen, svg_cam, _1), &svg_cam, svg_surface);
   m_draw_callback(&g);
 
@@ -171,6 +178,7 @@ bool canvas::print_png(const char *file_name, int output_width, int output_heigh
   using namespace std::placeholders;
   camera png_cam = m_camera;
   png_cam.update_widget(surface_width, surface_height);
+  draw_scene(context, &png_cam, png_surface);
   renderer g(context, std::bind(&camera::world_to_screen, png_cam, _1), &png_cam, png_surface);
   m_draw_callback(&g);
 
@@ -202,7 +210,7 @@ gboolean canvas::configure_event(GtkWidget *widget, GdkEventConfigure *, gpointe
   }
 
   // Something has changed, recreate the surface.
-  p_surface = create_surface(widget);
+  p_surface = create_surface(widget, ezgl_canvas->m_backend);
 
   // Recreate the context
   p_context = create_context(p_surface);
@@ -215,7 +223,8 @@ gboolean canvas::configure_event(GtkWidget *widget, GdkEventConfigure *, gpointe
 
   // Update the animation renderer
   if(ezgl_canvas->m_animation_renderer != nullptr)
-    ezgl_canvas->m_animation_renderer->update_renderer(p_context, p_surface);
+    ezgl_canvas->m_animation_renderer->update_renderer(
+        p_context, p_surface, ezgl_canvas->m_backend == render_backend::x11);
 
   g_info("canvas::configure_event has been handled.");
   return TRUE; // the configure event was handled
@@ -230,6 +239,26 @@ gboolean canvas::draw_surface(GtkWidget *, cairo_t *context, gpointer data)
   cairo_set_source_surface(context, p_surface, 0, 0);
   cairo_paint(context);
 
+  // Overlays are drawn on the widget, over the rendered frame, so they can change without a redraw
+  auto cnv = static_cast<canvas *>(data);
+  if(cnv->m_highlight_drawn) {
+    cairo_set_source_surface(context, cnv->m_highlight_surface, 0, 0);
+    cairo_paint(context);
+  }
+
+  if(cnv->m_show_selection_box) {
+    rectangle const &box = cnv->m_selection_box;
+
+    cairo_save(context);
+    cairo_rectangle(context, box.left() + 0.5, box.bottom() + 0.5, box.width(), box.height());
+    cairo_set_source_rgba(context, 0.2, 0.4, 1.0, 0.15);
+    cairo_fill_preserve(context);
+    cairo_set_source_rgba(context, 0.2, 0.4, 1.0, 0.9);
+    cairo_set_line_width(context, 1);
+    cairo_stroke(context);
+    cairo_restore(context);
+  }
+
   return FALSE;
 }
 
@@ -241,11 +270,20 @@ canvas::canvas(std::string canvas_id,
     , m_draw_callback(draw_callback)
     , m_camera(coordinate_system)
     , m_background_color(background_color)
+    , m_dynamic_index(coordinate_system)
 {
 }
 
 canvas::~canvas()
 {
+  if(m_stream_source != 0) {
+    g_source_remove(m_stream_source);
+  }
+
+  if(m_slice_source != 0) {
+    g_source_remove(m_slice_source);
+  }
+
   if(m_surface != nullptr) {
     cairo_surface_destroy(m_surface);
   }
@@ -257,6 +295,22 @@ canvas::~canvas()
   if(m_animation_renderer != nullptr) {
     delete m_animation_renderer;
   }
+
+  if(m_id_surface != nullptr) {
+    cairo_surface_destroy(m_id_surface);
+  }
+
+  if(m_highlight_surface != nullptr) {
+    cairo_surface_destroy(m_highlight_surface);
+  }
+
+  if(m_index_surface != nullptr) {
+    cairo_surface_destroy(m_index_surface);
+  }
+
+  if(m_indexed_color_surface != nullptr) {
+    cairo_surface_destroy(m_indexed_color_surface);
+  }
 }
 
 int canvas::width() const
@@ -274,7 +328,7 @@ void canvas::initialize(GtkWidget *drawing_area)
   g_return_if_fail(drawing_area != nullptr);
 
   m_drawing_area = drawing_area;
-  m_surface = create_surface(m_drawing_area);
+  m_surface = create_surface(m_drawing_area, m_backend);
   m_context = create_context(m_surface);
   m_camera.update_widget(width(), height());
 
@@ -297,27 +351,599 @@ void canvas::initialize(GtkWidget *drawing_area)
 
 void canvas::redraw()
 {
-  // Clear the screen and set the background color
-  cairo_set_source_rgb(m_context, m_background_color.red / 255.0, m_background_color.green / 255.0,
-      m_background_color.blue / 255.0);
-  cairo_paint(m_context);
+  // A new frame replaces the one being drawn in slices
+  ++m_frame;
+  m_resume_point = 0;
 
-  using namespace std::placeholders;
-  renderer g(m_context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, m_surface);
-  m_draw_callback(&g);
+  if(m_slice_source != 0) {
+    g_source_remove(m_slice_source);
+    m_slice_source = 0;
+  }
+
+  if(!draw_frame_slice(true)) {
+    m_slice_world = m_camera.get_world();
+    m_slice_source = g_idle_add(continue_frame, this);
+  }
+
+  if(!m_highlight_ids.empty())
+    draw_highlight(true);
 
   gtk_widget_queue_draw(m_drawing_area);
 
   g_info("The canvas will be redrawn.");
 }
 
+bool canvas::draw_frame_slice(bool first)
+{
+  // The recording and null backends draw the frame to a surface of their own
+  cairo_surface_t *frame_surface = m_surface;
+  cairo_t *frame = m_context;
+
+  if(m_backend == render_backend::recording)
+    frame_surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+  else if(m_backend == render_backend::null)
+    frame_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
+
+  if(frame_surface != m_surface)
+    frame = create_context(frame_surface);
+
+  // The null backend measures the draw callback alone, so the retained scene is not drawn
+  if(first && m_backend != render_backend::null) {
+    // Clear the screen and set the background color
+    cairo_set_source_rgb(frame, m_background_color.red / 255.0, m_background_color.green / 255.0,
+        m_background_color.blue / 255.0);
+    cairo_paint(frame);
+
+    if(m_indexed_rendering)
+      draw_indexed_scene(frame);
+    else
+      draw_scene(frame, &m_camera, frame_surface);
+  }
+
+  // The callback may let GTK handle events, and a redraw then starts a newer frame
+  std::uint64_t const frame_number = m_frame;
+  bool suspended = false;
+  {
+    using namespace std::placeholders;
+    renderer g(frame, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, frame_surface,
+        m_backend == render_backend::x11);
+
+    g.m_frame = frame_number;
+    g.m_latest_frame = &m_frame;
+    g.m_resume_point = m_resume_point;
+    if(m_time_slice > 0)
+      g.m_deadline = g_get_monotonic_time() + 1000 * static_cast<gint64>(m_time_slice);
+
+    m_draw_callback(&g);
+
+    if(g.m_suspended && frame_number == m_frame) {
+      suspended = true;
+      m_resume_point = g.m_next_resume_point;
+    }
+  }
+
+  if(frame != m_context) {
+    // Replay the recorded commands; the null backend drops the frame
+    if(m_backend == render_backend::recording) {
+      cairo_set_source_surface(m_context, frame_surface, 0, 0);
+      cairo_paint(m_context);
+    }
+
+    cairo_destroy(frame);
+    cairo_surface_destroy(frame_surface);
+  }
+
+  return !suspended;
+}
+
+gboolean canvas::continue_frame(gpointer self)
+{
+  auto cnv = static_cast<canvas *>(self);
+
+  // The view changed without a redraw: the rest of the frame would not match what is already drawn, so start over
+  if(!(cnv->m_camera.get_world() == cnv->m_slice_world)) {
+    cnv->m_slice_source = 0;
+    cnv->redraw();
+
+    return FALSE;
+  }
+
+  std::uint64_t const frame_number = cnv->m_frame;
+  bool complete = cnv->draw_frame_slice(false);
+
+  // A redraw during the slice started a newer frame, which has its own source
+  if(cnv->m_frame != frame_number)
+    return FALSE;
+
+  // Show the partial frame
+  gtk_widget_queue_draw(cnv->m_drawing_area);
+
+  if(!complete)
+    return TRUE;
+
+  cnv->m_slice_source = 0;
+
+  return FALSE;
+}
+
+void canvas::set_time_slice(int milliseconds)
+{
+  m_time_slice = std::max(milliseconds, 0);
+}
+
+void canvas::draw_scene(cairo_t *context, camera *cam, cairo_surface_t *p_surface)
+{
+  if(m_scene.empty())
+    return;
+
+  // The renderer shares the context with the draw callback, so save the context to keep the scene's color, line width,
+  // dash, cap and font from leaking into the callback
+  cairo_save(context);
+
+  {
+    using namespace std::placeholders;
+    renderer g(
+        context, std::bind(&camera::world_to_screen, cam, _1), cam, p_surface, m_backend == render_backend::x11);
+    m_scene.draw(&g);
+  }
+
+  cairo_restore(context);
+}
+
+primitive_id canvas::pick(point2d world, double tolerance_pixels)
+{
+  point2d scale = m_camera.get_world_scale_factor();
+  double tolerance = tolerance_pixels * std::max(std::abs(scale.x), std::abs(scale.y));
+
+  // Moving objects are drawn by the draw callback, on top of the scene
+  quadtree_handle handle = m_dynamic_index.pick(world, tolerance);
+  if(handle != NO_QUADTREE_HANDLE)
+    return m_dynamic_index.id(handle);
+
+  return m_scene.pick(world, tolerance);
+}
+
+void canvas::set_highlight(std::vector<primitive_id> const &ids, scene_style style)
+{
+  m_highlight_ids = ids;
+  m_highlight_style = style;
+
+  draw_highlight(false);
+}
+
+void canvas::clear_highlight()
+{
+  m_highlight_ids.clear();
+
+  draw_highlight(false);
+}
+
+void canvas::draw_highlight(bool view_changed)
+{
+  if(m_drawing_area == nullptr)
+    return;
+
+  // The null backend runs only the draw callback; the overlay is created again when another backend is chosen
+  if(m_backend == render_backend::null) {
+    if(m_highlight_surface != nullptr)
+      cairo_surface_destroy(m_highlight_surface);
+
+    m_highlight_surface = nullptr;
+    m_highlight_drawn = false;
+    return;
+  }
+
+  // The overlay is created on first use, and again when the widget is resized
+  if(m_highlight_surface == nullptr || cairo_image_surface_get_width(m_highlight_surface) != width() ||
+      cairo_image_surface_get_height(m_highlight_surface) != height()) {
+    if(m_highlight_surface != nullptr)
+      cairo_surface_destroy(m_highlight_surface);
+
+    m_highlight_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height());
+    m_highlight_drawn = false;
+  }
+
+  cairo_t *context = cairo_create(m_highlight_surface);
+
+  // Erase the previous highlight
+  if(m_highlight_drawn) {
+    rectangle const &old = m_highlight_extent;
+
+    cairo_save(context);
+    if(!view_changed) {
+      cairo_rectangle(context, old.left(), old.bottom(), old.width(), old.height());
+      cairo_clip(context);
+    }
+    cairo_set_operator(context, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(context, 0, 0, 0, 0);
+    cairo_paint(context);
+    cairo_restore(context);
+
+    gtk_widget_queue_draw_area(m_drawing_area, static_cast<int>(old.left()), static_cast<int>(old.bottom()),
+        static_cast<int>(old.width()), static_cast<int>(old.height()));
+    m_highlight_drawn = false;
+  }
+
+  rectangle bounds;
+  if(!m_highlight_ids.empty()) {
+    using namespace std::placeholders;
+    renderer g(context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, m_highlight_surface);
+
+    m_highlight_drawn = m_scene.draw_highlight(&g, m_highlight_ids, m_highlight_style, bounds);
+  }
+
+  cairo_destroy(context);
+  cairo_surface_flush(m_highlight_surface);
+
+  if(!m_highlight_drawn)
+    return;
+
+  // The pixels covered, including line widths, limited to the widget
+  point2d first = m_camera.world_to_screen(bounds.bottom_left());
+  point2d second = m_camera.world_to_screen(bounds.top_right());
+  double margin = m_highlight_style.line_width + 2;
+
+  double left = std::max(0.0, std::floor(std::min(first.x, second.x) - margin));
+  double top = std::max(0.0, std::floor(std::min(first.y, second.y) - margin));
+  double right = std::min<double>(width(), std::ceil(std::max(first.x, second.x) + margin));
+  double bottom = std::min<double>(height(), std::ceil(std::max(first.y, second.y) + margin));
+
+  m_highlight_extent = {{left, top}, {std::max(left, right), std::max(top, bottom)}};
+
+  rectangle const &extent = m_highlight_extent;
+  gtk_widget_queue_draw_area(m_drawing_area, static_cast<int>(extent.left()), static_cast<int>(extent.bottom()),
+      static_cast<int>(extent.width()), static_cast<int>(extent.height()));
+}
+
+void canvas::set_indexed_rendering(bool enabled)
+{
+  m_indexed_rendering = enabled;
+
+  if(!enabled) {
+    if(m_index_surface != nullptr)
+      cairo_surface_destroy(m_index_surface);
+    if(m_indexed_color_surface != nullptr)
+      cairo_surface_destroy(m_indexed_color_surface);
+
+    m_index_surface = nullptr;
+    m_indexed_color_surface = nullptr;
+    m_palette.clear();
+    m_palette.shrink_to_fit();
+  }
+
+  m_index_stale = true;
+}
+
+void canvas::invalidate_indices()
+{
+  m_index_stale = true;
+}
+
+void canvas::draw_indexed_scene(cairo_t *frame)
+{
+  if(m_scene.empty() || m_drawing_area == nullptr)
+    return;
+
+  // The buffers are created on first use, and again when the widget is resized
+  if(m_index_surface == nullptr || cairo_image_surface_get_width(m_index_surface) != width() ||
+      cairo_image_surface_get_height(m_index_surface) != height()) {
+    if(m_index_surface != nullptr)
+      cairo_surface_destroy(m_index_surface);
+    if(m_indexed_color_surface != nullptr)
+      cairo_surface_destroy(m_indexed_color_surface);
+
+    m_index_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height());
+    m_indexed_color_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height());
+    m_index_stale = true;
+  }
+
+  if(!(m_camera.get_world() == m_index_world))
+    m_index_stale = true;
+
+  if(m_index_stale) {
+    cairo_t *context = cairo_create(m_index_surface);
+
+    // Colors are palette indices, so they must not be blended
+    cairo_set_antialias(context, CAIRO_ANTIALIAS_NONE);
+
+    cairo_set_operator(context, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(context, 0, 0, 0, 0);
+    cairo_paint(context);
+    cairo_set_operator(context, CAIRO_OPERATOR_OVER);
+
+    using namespace std::placeholders;
+    renderer g(context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, m_index_surface);
+    m_scene.draw_style_indices(&g, g.get_visible_world());
+
+    cairo_destroy(context);
+    cairo_surface_flush(m_index_surface);
+
+    m_index_world = m_camera.get_world();
+    m_index_stale = false;
+  }
+
+  // Map the indices to colors; pixels no primitive covers map to transparent
+  m_scene.palette(m_palette);
+
+  std::uint32_t const *lut = m_palette.data();
+  std::size_t const lut_size = m_palette.size();
+
+  cairo_surface_flush(m_indexed_color_surface);
+
+  unsigned char const *index_data = cairo_image_surface_get_data(m_index_surface);
+  unsigned char *color_data = cairo_image_surface_get_data(m_indexed_color_surface);
+  int index_stride = cairo_image_surface_get_stride(m_index_surface);
+  int color_stride = cairo_image_surface_get_stride(m_indexed_color_surface);
+  int columns = cairo_image_surface_get_width(m_index_surface);
+  int rows = cairo_image_surface_get_height(m_index_surface);
+
+  for(int y = 0; y < rows; ++y) {
+    auto indices = reinterpret_cast<std::uint32_t const *>(index_data + y * index_stride);
+    auto colors = reinterpret_cast<std::uint32_t *>(color_data + y * color_stride);
+
+    for(int x = 0; x < columns; ++x) {
+      std::uint32_t index = indices[x] & 0xFFFFFF;
+      colors[x] = index < lut_size ? lut[index] : 0;
+    }
+  }
+
+  cairo_surface_mark_dirty(m_indexed_color_surface);
+
+  cairo_set_source_surface(frame, m_indexed_color_surface, 0, 0);
+  cairo_paint(frame);
+}
+
+void canvas::set_id_buffer_enabled(bool enabled)
+{
+  m_id_buffer_enabled = enabled;
+
+  if(!enabled && m_id_surface != nullptr) {
+    cairo_surface_destroy(m_id_surface);
+    m_id_surface = nullptr;
+    m_id_slots.clear();
+    m_id_slots.shrink_to_fit();
+  }
+}
+
+void canvas::invalidate_ids(rectangle const &world_region)
+{
+  m_id_dirty.push_back(world_region);
+}
+
+void canvas::invalidate_ids()
+{
+  m_id_stale = true;
+}
+
+void canvas::update_id_buffer()
+{
+  // The buffer is created on first use, and again when the widget is resized
+  if(m_id_surface == nullptr || cairo_image_surface_get_width(m_id_surface) != width() ||
+      cairo_image_surface_get_height(m_id_surface) != height()) {
+    if(m_id_surface != nullptr)
+      cairo_surface_destroy(m_id_surface);
+
+    m_id_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height());
+    m_id_stale = true;
+  }
+
+  // Slots are 24-bit colors; start over before they run out
+  if(!(m_camera.get_world() == m_id_world) || m_id_slots.size() >= 0xFFFFFF)
+    m_id_stale = true;
+
+  if(!m_id_stale && m_id_dirty.empty())
+    return;
+
+  cairo_t *context = cairo_create(m_id_surface);
+
+  // Colors are slot numbers, so they must not be blended
+  cairo_set_antialias(context, CAIRO_ANTIALIAS_NONE);
+
+  using namespace std::placeholders;
+  renderer g(context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, m_id_surface);
+
+  if(m_id_stale) {
+    m_id_dirty.assign(1, g.get_visible_world());
+    m_id_slots.clear();
+    m_id_world = m_camera.get_world();
+    m_id_stale = false;
+  }
+
+  for(rectangle const &region : m_id_dirty) {
+    point2d first = m_camera.world_to_screen(region.bottom_left());
+    point2d second = m_camera.world_to_screen(region.top_right());
+
+    // Clear and redraw only the pixels of the region; draw_ids also draws the lines that reach into it from outside
+    cairo_save(context);
+    cairo_rectangle(context, std::floor(std::min(first.x, second.x)), std::floor(std::min(first.y, second.y)),
+        std::ceil(std::abs(second.x - first.x)) + 1, std::ceil(std::abs(second.y - first.y)) + 1);
+    cairo_clip(context);
+
+    cairo_set_operator(context, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(context, 0, 0, 0, 0);
+    cairo_paint(context);
+    cairo_set_operator(context, CAIRO_OPERATOR_OVER);
+
+    m_scene.draw_ids(&g, region, m_id_slots);
+    cairo_restore(context);
+  }
+
+  m_id_dirty.clear();
+
+  cairo_destroy(context);
+  cairo_surface_flush(m_id_surface);
+}
+
+primitive_id canvas::id_at(point2d widget)
+{
+  if(!m_id_buffer_enabled || m_drawing_area == nullptr || m_backend == render_backend::null)
+    return 0;
+
+  update_id_buffer();
+
+  auto x = static_cast<int>(std::floor(widget.x));
+  auto y = static_cast<int>(std::floor(widget.y));
+  if(x < 0 || y < 0 || x >= cairo_image_surface_get_width(m_id_surface) ||
+      y >= cairo_image_surface_get_height(m_id_surface))
+    return 0;
+
+  unsigned char const *row =
+      cairo_image_surface_get_data(m_id_surface) + y * cairo_image_surface_get_stride(m_id_surface);
+  std::uint32_t slot = reinterpret_cast<std::uint32_t const *>(row)[x] & 0xFFFFFF;
+
+  return slot < m_id_slots.size() ? m_id_slots[slot] : 0;
+}
+
+std::vector<primitive_id> canvas::select(rectangle const &world_region)
+{
+  std::vector<primitive_id> ids;
+
+  m_dynamic_index.query(world_region, [&](quadtree_handle, rectangle const &, primitive_id id) {
+    if(id != 0)
+      ids.push_back(id);
+  });
+
+  m_scene.query(world_region, [&](scene_primitive const &p) {
+    if(p.id != 0)
+      ids.push_back(p.id);
+  });
+
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  return ids;
+}
+
+void canvas::set_selection_box(rectangle const &widget_box)
+{
+  // Repaint where the old box was and where the new one is
+  if(m_show_selection_box)
+    queue_draw_selection_box();
+
+  m_selection_box = widget_box;
+  m_show_selection_box = true;
+  queue_draw_selection_box();
+}
+
+void canvas::clear_selection_box()
+{
+  if(!m_show_selection_box)
+    return;
+
+  queue_draw_selection_box();
+  m_show_selection_box = false;
+}
+
+void canvas::queue_draw_selection_box()
+{
+  if(m_drawing_area == nullptr)
+    return;
+
+  // Include the outline, which straddles the edges
+  int x = static_cast<int>(std::floor(m_selection_box.left())) - 1;
+  int y = static_cast<int>(std::floor(m_selection_box.bottom())) - 1;
+  int width = static_cast<int>(std::ceil(m_selection_box.width())) + 3;
+  int height = static_cast<int>(std::ceil(m_selection_box.height())) + 3;
+
+  gtk_widget_queue_draw_area(m_drawing_area, x, y, width, height);
+}
+
+bool canvas::save_scene(const char *file_name)
+{
+  return m_scene.save(file_name);
+}
+
+bool canvas::load_scene(const char *file_name, bool paged)
+{
+  bool loaded = paged ? m_scene.load_paged(file_name) : m_scene.load(file_name);
+
+  // The ID and style index buffers hold the previous scene
+  invalidate_ids();
+  m_index_stale = true;
+
+  return loaded;
+}
+
+// How often a streaming scene is checked for newly read pages
+static constexpr guint SCENE_STREAM_INTERVAL_MS = 50;
+
+bool canvas::stream_scene(const char *file_name, std::size_t memory_budget)
+{
+  bool started = m_scene.stream(file_name, memory_budget);
+
+  // The ID and style index buffers hold the previous scene
+  invalidate_ids();
+  m_index_stale = true;
+
+  if(!started)
+    return false;
+
+  if(m_stream_source == 0 && m_scene.is_streaming())
+    m_stream_source = g_timeout_add(SCENE_STREAM_INTERVAL_MS, update_scene_stream, this);
+
+  return true;
+}
+
+gboolean canvas::update_scene_stream(gpointer self)
+{
+  auto cnv = static_cast<canvas *>(self);
+
+  rectangle updated;
+  if(cnv->m_scene.update_stream(updated) && cnv->m_drawing_area != nullptr) {
+    if(cnv->m_id_buffer_enabled)
+      cnv->invalidate_ids(updated);
+
+    // Only redraw if the new pages are on screen
+    point2d corner_a = cnv->m_camera.widget_to_world({0, 0});
+    point2d corner_b = cnv->m_camera.widget_to_world({double(cnv->width()), double(cnv->height())});
+
+    bool visible = updated.right() >= std::min(corner_a.x, corner_b.x) &&
+                   updated.left() <= std::max(corner_a.x, corner_b.x) &&
+                   updated.top() >= std::min(corner_a.y, corner_b.y) &&
+                   updated.bottom() <= std::max(corner_a.y, corner_b.y);
+
+    if(visible) {
+      cnv->m_index_stale = true;
+      cnv->redraw();
+    }
+  }
+
+  if(cnv->m_scene.is_streaming())
+    return TRUE;
+
+  cnv->m_stream_source = 0;
+
+  return FALSE;
+}
+
 renderer *canvas::create_animation_renderer()
 {
   if(m_animation_renderer == nullptr) {
     using namespace std::placeholders;
-    m_animation_renderer = new renderer(m_context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera, m_surface);
+    m_animation_renderer = new renderer(m_context, std::bind(&camera::world_to_screen, &m_camera, _1), &m_camera,
+        m_surface, m_backend == render_backend::x11);
   }
 
   return m_animation_renderer;
 }
+
+void canvas::set_render_backend(render_backend backend)
+{
+  m_backend = backend;
+
+  if(m_drawing_area == nullptr)
+    return;
+
+  // The backend decides the kind of surface, so recreate it as on a configure event
+  cairo_surface_destroy(m_surface);
+  cairo_destroy(m_context);
+
+  m_surface = create_surface(m_drawing_area, m_backend);
+  m_context = create_context(m_surface);
+
+  redraw();
+
+  if(m_animation_renderer != nullptr)
+    m_animation_renderer->update_renderer(m_context, m_surface, m_backend == render_backend::x11);
+}
 } // namespace ezgl
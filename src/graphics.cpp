@@ -23,15 +23,44 @@
 
 namespace ezgl {
 
+render_backend render_backend_from_environment()
+{
+#ifdef EZGL_USE_X11
+  render_backend const fallback = render_backend::x11;
+#else
+  render_backend const fallback = render_backend::cairo_image;
+#endif
+
+  char const *name = g_getenv("EZGL_BACKEND");
+  if(name == nullptr || name[0] == '\0')
+    return fallback;
+
+  std::string const value = name;
+  if(value == "x11")
+    return render_backend::x11;
+  if(value == "cairo")
+    return render_backend::cairo;
+  if(value == "image")
+    return render_backend::cairo_image;
+  if(value == "recording")
+    return render_backend::recording;
+  if(value == "null")
+    return render_backend::null;
+
+  g_warning("render_backend_from_environment: Unknown backend \"%s\" in EZGL_BACKEND.", name);
+  return fallback;
+}
+
 renderer::renderer(cairo_t *cairo,
     transform_fn transform,
     camera *p_camera,
-    cairo_surface_t *m_surface)
-    : m_cairo(cairo), m_transform(std::move(transform)), m_camera(p_camera), rotation_angle(0)
+    cairo_surface_t *m_surface,
+    bool use_x11)
+    : m_cairo(cairo), m_transform(std::move(transform)), m_camera(p_camera), rotation_angle(0), m_use_x11(use_x11)
 {
 #ifdef EZGL_USE_X11
   // Check if the created cairo surface is an XLIB surface
-  if (cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_XLIB) {
+  if (m_use_x11 && cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_XLIB) {
     // get the underlying x11 drawable used by cairo surface
     x11_drawable = cairo_xlib_surface_get_drawable(m_surface);
 
@@ -56,15 +85,22 @@ renderer::~renderer()
 #endif
 }
 
-void renderer::update_renderer(cairo_t *cairo, cairo_surface_t *m_surface)
+void renderer::update_renderer(cairo_t *cairo, cairo_surface_t *m_surface, bool use_x11)
 {
   // Update Cairo Context
   m_cairo = cairo;
+  m_use_x11 = use_x11;
 
   // Update X11 Context
 #ifdef EZGL_USE_X11
+  // free the previous x11 context, which the new surface may not use
+  if (x11_display != nullptr) {
+    XFreeGC(x11_display, x11_context);
+    x11_display = nullptr;
+  }
+
   // Check if the created cairo surface is an XLIB surface
-  if (cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_XLIB) {
+  if (m_use_x11 && cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_XLIB) {
     // get the underlying x11 drawable used by cairo surface
     x11_drawable = cairo_xlib_surface_get_drawable(m_surface);
 
@@ -73,7 +109,6 @@ void renderer::update_renderer(cairo_t *cairo, cairo_surface_t *m_surface)
 
     // create the x11 context from the drawable of the cairo surface
     if (x11_display != nullptr) {
-      XFreeGC(x11_display, x11_context);
       x11_context = XCreateGC(x11_display, x11_drawable, 0, 0);
     }
   }
@@ -143,6 +178,20 @@ rectangle renderer::get_visible_screen()
   return m_camera->get_widget();
 }
 
+bool renderer::out_of_time() const
+{
+  if(m_latest_frame != nullptr && *m_latest_frame != m_frame)
+    return true;
+
+  return m_deadline != 0 && g_get_monotonic_time() >= m_deadline;
+}
+
+void renderer::suspend(std::size_t resume_point)
+{
+  m_suspended = true;
+  m_next_resume_point = resume_point;
+}
+
 rectangle renderer::world_to_screen(const rectangle& box)
 {
   point2d origin = m_transform(box.bottom_left());
@@ -187,28 +236,25 @@ void renderer::set_color(uint_fast8_t red,
     uint_fast8_t green,
     uint_fast8_t blue,
     uint_fast8_t alpha)
+{
+  set_packed_color({red, green, blue, alpha});
+}
+
+void renderer::set_packed_color(packed_color c)
 {
   // set color for cairo
-  cairo_set_source_rgba(m_cairo, red / 255.0, green / 255.0, blue / 255.0, alpha / 255.0);
+  cairo_set_source_rgba(m_cairo, c.cairo_red(), c.cairo_green(), c.cairo_blue(), c.cairo_alpha());
 
   // set current_color
-  current_color = {red, green, blue, alpha};
+  current_color = c.unpack();
 
 #ifdef EZGL_USE_X11
   // check transparency
-  if(alpha != 255)
-    transparency_flag = true;
-  else
-    transparency_flag = false;
+  transparency_flag = c.alpha() != 255;
 
   // set color for x11 (no transparency)
   if (x11_display != nullptr) {
-    unsigned long xcolor = 0;
-    xcolor |= (red << 2 * 8 | red << 8 | red) & 0xFF0000;
-    xcolor |= (green << 2 * 8 | green << 8 | green) & 0xFF00;
-    xcolor |= (blue << 2 * 8 | blue << 8 | blue) & 0xFF;
-    xcolor |= 0xFF000000;
-    XSetForeground(x11_display, x11_context, xcolor);
+    XSetForeground(x11_display, x11_context, c.x11_pixel());
   }
 #endif
 }
@@ -391,6 +437,229 @@ void renderer::fill_rectangle(rectangle r)
 // Dynamically allocate an arbitrary size buffer only when necessary.
 #define X11_MAX_FIXED_POLY_PTS 100
 
+template <typename Draw>
+void renderer::for_each_color(std::vector<packed_color> const &colors, Draw &&draw)
+{
+  m_batch_order.resize(colors.size());
+  for(std::size_t i = 0; i < colors.size(); ++i)
+    m_batch_order[i] = static_cast<std::uint32_t>(i);
+
+  // Stable, so that items of the same color keep their order
+  std::stable_sort(m_batch_order.begin(), m_batch_order.end(),
+      [&colors](std::uint32_t a, std::uint32_t b) { return colors[a].value < colors[b].value; });
+
+  color saved_color = current_color;
+
+  for(std::size_t first = 0; first < m_batch_order.size();) {
+    packed_color c = colors[m_batch_order[first]];
+
+    std::size_t last = first + 1;
+    while(last < m_batch_order.size() && colors[m_batch_order[last]] == c)
+      ++last;
+
+    set_packed_color(c);
+    draw(m_batch_order.data() + first, last - first);
+
+    first = last;
+  }
+
+  set_color(saved_color);
+}
+
+void renderer::draw_lines(std::vector<line_segment> const &segments)
+{
+  draw_line_batch([&segments](std::size_t i) { return segments[i]; }, segments.size());
+}
+
+void renderer::draw_lines(std::vector<line_segment> const &segments, std::vector<packed_color> const &colors)
+{
+  if(colors.size() != segments.size()) {
+    g_warning("renderer::draw_lines: There are %zu colors for %zu segments.", colors.size(), segments.size());
+    return;
+  }
+
+  for_each_color(colors, [&](std::uint32_t const *indices, std::size_t count) {
+    draw_line_batch([&](std::size_t i) { return segments[indices[i]]; }, count);
+  });
+}
+
+void renderer::fill_rectangles(std::vector<rectangle> const &rects)
+{
+  fill_rectangle_batch([&rects](std::size_t i) { return rects[i]; }, rects.size());
+}
+
+void renderer::fill_rectangles(std::vector<rectangle> const &rects, std::vector<packed_color> const &colors)
+{
+  if(colors.size() != rects.size()) {
+    g_warning("renderer::fill_rectangles: There are %zu colors for %zu rectangles.", colors.size(), rects.size());
+    return;
+  }
+
+  for_each_color(colors, [&](std::uint32_t const *indices, std::size_t count) {
+    fill_rectangle_batch([&](std::size_t i) { return rects[indices[i]]; }, count);
+  });
+}
+
+void renderer::draw_arrows(std::vector<line_segment> const &segments, double head_size)
+{
+  draw_arrow_batch([&segments](std::size_t i) { return segments[i]; }, segments.size(), head_size);
+}
+
+void renderer::submit_arrows()
+{
+  submit_lines(m_batch_segments);
+
+  if(m_batch_heads.empty())
+    return;
+
+#ifdef EZGL_USE_X11
+  if(!transparency_flag && x11_display != nullptr) {
+    // X11 has no request for many polygons, but Xlib buffers the requests
+    for(std::size_t i = 0; i < m_batch_heads.size(); i += 3) {
+      XPoint head[3];
+      for(int k = 0; k < 3; ++k) {
+        head[k].x = static_cast<short>(m_batch_heads[i + k].x);
+        head[k].y = static_cast<short>(m_batch_heads[i + k].y);
+      }
+
+      XFillPolygon(x11_display, x11_drawable, x11_context, head, 3, Convex, CoordModeOrigin);
+    }
+    return;
+  }
+#endif
+
+  for(std::size_t i = 0; i < m_batch_heads.size(); i += 3) {
+    cairo_move_to(m_cairo, m_batch_heads[i].x, m_batch_heads[i].y);
+    cairo_line_to(m_cairo, m_batch_heads[i + 1].x, m_batch_heads[i + 1].y);
+    cairo_line_to(m_cairo, m_batch_heads[i + 2].x, m_batch_heads[i + 2].y);
+    cairo_close_path(m_cairo);
+  }
+
+  cairo_fill(m_cairo);
+}
+
+void renderer::draw_graph(std::vector<point2d> const &nodes,
+    std::vector<std::uint32_t> const &edge_offsets,
+    std::vector<std::uint32_t> const &edge_targets,
+    short_edges short_edge_mode)
+{
+  if(edge_offsets.size() != nodes.size() + 1 || edge_offsets.back() > edge_targets.size()) {
+    g_warning("renderer::draw_graph: The edge offsets do not match the %zu nodes and %zu edges.", nodes.size(),
+        edge_targets.size());
+    return;
+  }
+
+  bool world = current_coordinate_system == WORLD;
+  rectangle visible = world ? get_visible_world() : rectangle();
+  double const left = visible.left(), right = visible.right(), bottom = visible.bottom(), top = visible.top();
+
+  // Transform inline rather than through m_transform, which is called per point
+  cairo_matrix_t const m = current_matrix();
+  auto const node_count = static_cast<std::uint32_t>(nodes.size());
+  auto const edge_count = static_cast<std::uint32_t>(edge_targets.size());
+
+  m_batch_segments.clear();
+  m_batch_short_segments.clear();
+
+  for(std::uint32_t u = 0; u < node_count; ++u) {
+    point2d const a = nodes[u];
+
+    std::uint32_t last_edge = std::min(edge_offsets[u + 1], edge_count);
+
+    for(std::uint32_t e = edge_offsets[u]; e < last_edge; ++e) {
+      std::uint32_t v = edge_targets[e];
+      if(v >= node_count || v == u)
+        continue;
+
+      point2d const b = nodes[v];
+
+      // Skip edges whose bounding box is outside of the visible world
+      bool outside = (std::max(a.x, b.x) < left) | (std::min(a.x, b.x) > right) | (std::max(a.y, b.y) < bottom) |
+                     (std::min(a.y, b.y) > top);
+      if(world && outside)
+        continue;
+
+      line_segment s = {{m.xx * a.x + m.x0, m.yy * a.y + m.y0}, {m.xx * b.x + m.x0, m.yy * b.y + m.y0}};
+
+      double dx = s.end.x - s.start.x;
+      double dy = s.end.y - s.start.y;
+
+      if(short_edge_mode != short_edges::draw && dx * dx + dy * dy < 1) {
+        if(short_edge_mode == short_edges::fade)
+          m_batch_short_segments.push_back(s);
+        continue;
+      }
+
+      m_batch_segments.push_back(s);
+    }
+  }
+
+  submit_lines(m_batch_segments);
+
+  if(!m_batch_short_segments.empty()) {
+    color saved_color = current_color;
+    set_color(saved_color, saved_color.alpha / 4);
+    submit_lines(m_batch_short_segments);
+    set_color(saved_color);
+  }
+}
+
+void renderer::submit_lines(std::vector<line_segment> const &segments)
+{
+  if(segments.empty())
+    return;
+
+#ifdef EZGL_USE_X11
+  if(!transparency_flag && x11_display != nullptr) {
+    m_x11_segments.clear();
+    for(line_segment const &s : segments) {
+      m_x11_segments.push_back({static_cast<short>(s.start.x), static_cast<short>(s.start.y),
+          static_cast<short>(s.end.x), static_cast<short>(s.end.y)});
+    }
+
+    XDrawSegments(x11_display, x11_drawable, x11_context, m_x11_segments.data(), m_x11_segments.size());
+    return;
+  }
+#endif
+
+  for(line_segment const &s : segments) {
+    cairo_move_to(m_cairo, s.start.x, s.start.y);
+    cairo_line_to(m_cairo, s.end.x, s.end.y);
+  }
+
+  cairo_stroke(m_cairo);
+}
+
+void renderer::submit_rectangles(std::vector<rectangle> const &rects)
+{
+  if(rects.empty())
+    return;
+
+#ifdef EZGL_USE_X11
+  if(!transparency_flag && x11_display != nullptr) {
+    m_x11_rectangles.clear();
+    for(rectangle const &r : rects) {
+      // Add 0.5 for extra half-pixel accuracy
+      int start_x = static_cast<int>(r.left() + 0.5);
+      int start_y = static_cast<int>(r.bottom() + 0.5);
+      int end_x = static_cast<int>(r.right() + 0.5);
+      int end_y = static_cast<int>(r.top() + 0.5);
+
+      m_x11_rectangles.push_back({static_cast<short>(start_x), static_cast<short>(start_y),
+          static_cast<unsigned short>(end_x - start_x), static_cast<unsigned short>(end_y - start_y)});
+    }
+
+    XFillRectangles(x11_display, x11_drawable, x11_context, m_x11_rectangles.data(), m_x11_rectangles.size());
+    return;
+  }
+#endif
+
+  for(rectangle const &r : rects)
+    cairo_rectangle(m_cairo, r.left(), r.bottom(), r.width(), r.height());
+
+  cairo_fill(m_cairo);
+}
+
 void renderer::fill_poly(std::vector<point2d> const &points)
 {
   assert(points.size() > 1);
@@ -457,6 +726,52 @@ void renderer::fill_poly(std::vector<point2d> const &points)
   cairo_fill(m_cairo);
 }
 
+cairo_matrix_t renderer::current_matrix()
+{
+  cairo_matrix_t matrix;
+  cairo_matrix_init_identity(&matrix);
+
+  // The world to screen transform only scales and translates, so two points give the matrix
+  if(current_coordinate_system == WORLD) {
+    point2d origin = m_transform({0, 0});
+    point2d unit = m_transform({1, 1});
+    cairo_matrix_init(&matrix, unit.x - origin.x, 0, 0, unit.y - origin.y, origin.x, origin.y);
+  }
+
+  return matrix;
+}
+
+bool renderer::append_path(path const &p)
+{
+  if(p.empty() || rectangle_off_screen(p.bounds()))
+    return false;
+
+  cairo_matrix_t matrix = current_matrix();
+  cairo_path_t cairo_path = p.cairo_path();
+
+  // The path is converted to device coordinates as it is appended, so the matrix can be restored before stroking; this
+  // keeps line widths in pixels
+  cairo_save(m_cairo);
+  cairo_set_matrix(m_cairo, &matrix);
+  cairo_new_path(m_cairo);
+  cairo_append_path(m_cairo, &cairo_path);
+  cairo_restore(m_cairo);
+
+  return true;
+}
+
+void renderer::fill_path(path const &p)
+{
+  if(append_path(p))
+    cairo_fill(m_cairo);
+}
+
+void renderer::draw_path(path const &p)
+{
+  if(append_path(p))
+    cairo_stroke(m_cairo);
+}
+
 void renderer::draw_elliptic_arc(point2d center,
     double radius_x,
     double radius_y,
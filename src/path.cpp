@@ -0,0 +1,140 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/path.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace ezgl {
+
+void path::add_element(cairo_path_data_type_t type, point2d const *points, int count)
+{
+  bool first = m_data.empty();
+
+  cairo_path_data_t header;
+  header.header.type = type;
+  header.header.length = count + 1;
+  m_data.push_back(header);
+
+  for(int i = 0; i < count; ++i) {
+    if(first && i == 0) {
+      m_x0 = m_x1 = points[i].x;
+      m_y0 = m_y1 = points[i].y;
+    } else {
+      m_x0 = std::min(m_x0, points[i].x);
+      m_y0 = std::min(m_y0, points[i].y);
+      m_x1 = std::max(m_x1, points[i].x);
+      m_y1 = std::max(m_y1, points[i].y);
+    }
+
+    cairo_path_data_t point;
+    point.point.x = points[i].x;
+    point.point.y = points[i].y;
+    m_data.push_back(point);
+  }
+}
+
+void path::move_to(point2d point)
+{
+  add_element(CAIRO_PATH_MOVE_TO, &point, 1);
+
+  m_has_current_point = true;
+  m_current = m_start = point;
+}
+
+void path::line_to(point2d point)
+{
+  if(!m_has_current_point) {
+    move_to(point);
+    return;
+  }
+
+  add_element(CAIRO_PATH_LINE_TO, &point, 1);
+  m_current = point;
+}
+
+void path::curve_to(point2d control1, point2d control2, point2d end)
+{
+  point2d points[3] = {control1, control2, end};
+  add_element(CAIRO_PATH_CURVE_TO, points, 3);
+  m_current = end;
+}
+
+void path::arc(point2d center, double radius, double start_angle, double extent_angle)
+{
+  double start = start_angle * M_PI / 180;
+  double extent = extent_angle * M_PI / 180;
+
+  line_to({center.x + radius * std::cos(start), center.y + radius * std::sin(start)});
+
+  // Approximate the arc with one cubic curve per quarter turn or less
+  int segments = std::max(1, static_cast<int>(std::ceil(std::abs(extent) / (M_PI / 2) - 1e-9)));
+  double step = extent / segments;
+  double handle = 4.0 / 3.0 * std::tan(step / 4) * radius;
+
+  for(int i = 0; i < segments; ++i) {
+    double a = start + i * step;
+    double b = a + step;
+
+    point2d p0 = {center.x + radius * std::cos(a), center.y + radius * std::sin(a)};
+    point2d p3 = {center.x + radius * std::cos(b), center.y + radius * std::sin(b)};
+
+    curve_to({p0.x - handle * std::sin(a), p0.y + handle * std::cos(a)},
+        {p3.x + handle * std::sin(b), p3.y - handle * std::cos(b)}, p3);
+  }
+}
+
+void path::close()
+{
+  if(!m_has_current_point)
+    return;
+
+  add_element(CAIRO_PATH_CLOSE_PATH, nullptr, 0);
+
+  // Like cairo, continue from the first point of the closed sub-path
+  m_current = m_start;
+}
+
+void path::add_polygon(std::vector<point2d> const &points)
+{
+  assert(points.size() > 1);
+
+  move_to(points[0]);
+  for(std::size_t i = 1; i < points.size(); ++i)
+    line_to(points[i]);
+  close();
+}
+
+void path::add_rectangle(rectangle r)
+{
+  move_to({r.left(), r.bottom()});
+  line_to({r.right(), r.bottom()});
+  line_to({r.right(), r.top()});
+  line_to({r.left(), r.top()});
+  close();
+}
+
+void path::clear()
+{
+  m_data.clear();
+  m_has_current_point = false;
+  m_x0 = m_y0 = m_x1 = m_y1 = 0;
+}
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/quadtree.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ezgl {
+
+constexpr std::uint32_t loose_quadtree::NONE;
+
+loose_quadtree::loose_quadtree(rectangle world, std::uint32_t max_depth)
+    : m_world(world), m_max_depth(std::min(max_depth, QUADTREE_MAX_DEPTH))
+{
+  clear();
+}
+
+void loose_quadtree::clear()
+{
+  m_nodes.clear();
+  m_objects.clear();
+  m_free_node = NONE;
+  m_free_object = NONE;
+  m_size = 0;
+
+  // The root's cell is the smallest square around the world
+  point2d center = m_world.center();
+  double half_size = std::max(m_world.width(), m_world.height()) / 2;
+
+  node root;
+  root.center_x = center.x;
+  root.center_y = center.y;
+  root.half_size = half_size > 0 ? half_size : 1;
+  root.parent = NONE;
+  std::fill(std::begin(root.children), std::end(root.children), NONE);
+  root.num_children = 0;
+  root.first_object = NONE;
+  root.num_objects = 0;
+  root.depth = 0;
+  m_nodes.push_back(root);
+}
+
+std::uint32_t loose_quadtree::depth_for(rectangle const &bounds) const
+{
+  double size = std::max(bounds.width(), bounds.height());
+  double root_size = 2 * m_nodes[0].half_size;
+
+  if(size <= 0)
+    return m_max_depth;
+
+  if(size >= root_size)
+    return 0;
+
+  auto depth = static_cast<std::uint32_t>(std::min<double>(std::floor(std::log2(root_size / size)), m_max_depth));
+
+  // Guard against rounding: the cell at this depth must be at least as large as the object
+  while(depth > 0 && std::ldexp(root_size, -static_cast<int>(depth)) < size)
+    --depth;
+
+  return depth;
+}
+
+std::uint32_t loose_quadtree::node_for(rectangle const &bounds)
+{
+  point2d center = bounds.center();
+  node const &root = m_nodes[0];
+
+  if(std::abs(center.x - root.center_x) > root.half_size || std::abs(center.y - root.center_y) > root.half_size)
+    return 0;
+
+  std::uint32_t depth = depth_for(bounds);
+  std::uint32_t index = 0;
+
+  for(std::uint32_t level = 0; level < depth; ++level) {
+    node const &n = m_nodes[index];
+
+    // Leave room in nodes without children before subdividing them
+    if(n.num_children == 0 && n.num_objects < QUADTREE_NODE_CAPACITY)
+      break;
+
+    int quadrant = (center.x >= n.center_x ? 1 : 0) | (center.y >= n.center_y ? 2 : 0);
+
+    std::uint32_t child = n.children[quadrant];
+    if(child == NONE)
+      child = add_child(index, quadrant);
+
+    index = child;
+  }
+
+  return index;
+}
+
+std::uint32_t loose_quadtree::add_child(std::uint32_t parent, int quadrant)
+{
+  std::uint32_t index;
+  if(m_free_node != NONE) {
+    index = m_free_node;
+    m_free_node = m_nodes[index].parent;
+  } else {
+    index = static_cast<std::uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+  }
+
+  node &p = m_nodes[parent];
+  node &child = m_nodes[index];
+
+  child.half_size = p.half_size / 2;
+  child.center_x = p.center_x + ((quadrant & 1) ? child.half_size : -child.half_size);
+  child.center_y = p.center_y + ((quadrant & 2) ? child.half_size : -child.half_size);
+  child.parent = parent;
+  std::fill(std::begin(child.children), std::end(child.children), NONE);
+  child.num_children = 0;
+  child.first_object = NONE;
+  child.num_objects = 0;
+  child.depth = p.depth + 1;
+
+  p.children[quadrant] = index;
+  ++p.num_children;
+
+  return index;
+}
+
+void loose_quadtree::set_bounds(quadtree_handle handle, rectangle const &bounds)
+{
+  object &o = m_objects[handle];
+  o.bounds = bounds;
+  o.x0 = bounds.left();
+  o.y0 = bounds.bottom();
+  o.x1 = bounds.right();
+  o.y1 = bounds.top();
+}
+
+void loose_quadtree::link(quadtree_handle handle, std::uint32_t node_index)
+{
+  object &o = m_objects[handle];
+  node &n = m_nodes[node_index];
+
+  o.node = node_index;
+  o.previous = NONE;
+  o.next = n.first_object;
+
+  if(n.first_object != NONE)
+    m_objects[n.first_object].previous = handle;
+
+  n.first_object = handle;
+  ++n.num_objects;
+}
+
+void loose_quadtree::unlink(quadtree_handle handle)
+{
+  object &o = m_objects[handle];
+
+  if(o.previous != NONE)
+    m_objects[o.previous].next = o.next;
+  else
+    m_nodes[o.node].first_object = o.next;
+
+  if(o.next != NONE)
+    m_objects[o.next].previous = o.previous;
+
+  --m_nodes[o.node].num_objects;
+}
+
+void loose_quadtree::prune(std::uint32_t node_index)
+{
+  while(node_index != 0 && m_nodes[node_index].first_object == NONE && m_nodes[node_index].num_children == 0) {
+    std::uint32_t parent = m_nodes[node_index].parent;
+    node &p = m_nodes[parent];
+
+    std::replace(std::begin(p.children), std::end(p.children), node_index, NONE);
+    --p.num_children;
+
+    m_nodes[node_index].parent = m_free_node;
+    m_free_node = node_index;
+
+    node_index = parent;
+  }
+}
+
+quadtree_handle loose_quadtree::insert(rectangle const &bounds, primitive_id id)
+{
+  quadtree_handle handle;
+  if(m_free_object != NONE) {
+    handle = m_free_object;
+    m_free_object = m_objects[handle].next;
+  } else {
+    handle = static_cast<quadtree_handle>(m_objects.size());
+    m_objects.emplace_back();
+  }
+
+  m_objects[handle].id = id;
+  set_bounds(handle, bounds);
+  link(handle, node_for(bounds));
+  ++m_size;
+
+  return handle;
+}
+
+void loose_quadtree::remove(quadtree_handle handle)
+{
+  std::uint32_t old_node = m_objects[handle].node;
+  if(old_node == NONE)
+    return;
+
+  unlink(handle);
+  m_objects[handle].node = NONE;
+  m_objects[handle].next = m_free_object;
+  m_free_object = handle;
+  --m_size;
+
+  prune(old_node);
+}
+
+void loose_quadtree::move(quadtree_handle handle, rectangle const &bounds)
+{
+  std::uint32_t old_node = m_objects[handle].node;
+  if(old_node == NONE)
+    return;
+
+  set_bounds(handle, bounds);
+
+  // Stay in the same node if the object still fits its cell, its center is still in the cell, and it would not go to
+  // a child (it is too large for one, or the node has room)
+  node const &n = m_nodes[old_node];
+  point2d center = bounds.center();
+  double size = std::max(bounds.width(), bounds.height());
+  bool fits = n.depth == 0 || size <= 2 * n.half_size;
+  bool deeper = n.depth < m_max_depth && size <= n.half_size && n.num_children > 0;
+
+  if(fits && !deeper && std::abs(center.x - n.center_x) <= n.half_size &&
+      std::abs(center.y - n.center_y) <= n.half_size)
+    return;
+
+  unlink(handle);
+  link(handle, node_for(bounds));
+  prune(old_node);
+}
+
+quadtree_handle loose_quadtree::pick(point2d point, double tolerance) const
+{
+  quadtree_handle best = NO_QUADTREE_HANDLE;
+  double best_area = 0;
+
+  query({{point.x - tolerance, point.y - tolerance}, {point.x + tolerance, point.y + tolerance}},
+      [&](quadtree_handle handle, rectangle const &b, primitive_id) {
+        double area = b.area();
+        if(best == NO_QUADTREE_HANDLE || area < best_area) {
+          best = handle;
+          best_area = area;
+        }
+      });
+
+  return best;
+}
+}
@@ -0,0 +1,2480 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/scene.hpp"
+
+#include "ezgl/graphics.hpp"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ezgl {
+
+/**
+ * A read-only view of a whole file, memory-mapped where the platform supports it.
+ */
+class mapped_file {
+public:
+  explicit mapped_file(const char *file_path)
+  {
+#ifndef _WIN32
+    int fd = open(file_path, O_RDONLY);
+    if(fd < 0)
+      return;
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      void *mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(mapping != MAP_FAILED) {
+        m_data = static_cast<unsigned char const *>(mapping);
+        m_size = file_stat.st_size;
+      }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+#else
+    FILE *file = std::fopen(file_path, "rb");
+    if(file == nullptr)
+      return;
+
+    std::fseek(file, 0, SEEK_END);
+    m_buffer.resize(std::ftell(file));
+    std::fseek(file, 0, SEEK_SET);
+    if(std::fread(m_buffer.data(), 1, m_buffer.size(), file) == m_buffer.size()) {
+      m_data = m_buffer.data();
+      m_size = m_buffer.size();
+    }
+    std::fclose(file);
+#endif
+  }
+
+  ~mapped_file()
+  {
+#ifndef _WIN32
+    if(m_data != nullptr)
+      munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+  }
+
+  mapped_file(mapped_file const &) = delete;
+  mapped_file &operator=(mapped_file const &) = delete;
+
+  bool is_open() const
+  {
+    return m_data != nullptr;
+  }
+
+  unsigned char const *data() const
+  {
+    return m_data;
+  }
+
+  std::size_t size() const
+  {
+    return m_size;
+  }
+
+private:
+  unsigned char const *m_data = nullptr;
+  std::size_t m_size = 0;
+
+#ifdef _WIN32
+  std::vector<unsigned char> m_buffer;
+#endif
+};
+
+/**
+ * The first bytes of a scene file. Each section is aligned to SECTION_ALIGNMENT bytes so it can be used in place.
+ */
+struct scene_file_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t style_offset, style_count;
+  std::uint64_t primitive_offset, primitive_count;
+  std::uint64_t point_offset, point_count;
+  std::uint64_t node_offset, node_count;
+  std::uint64_t page_offset, page_count;
+  std::uint64_t transform_offset, transform_count;
+  std::uint64_t cell_offset, cell_count;
+  double bounds[4];
+  std::uint32_t next_order;
+  std::uint32_t page_level;
+  std::uint32_t reserved[4];
+};
+
+/**
+ * An entry of the cell table of a scene file. Each cell is stored as a complete scene file image, at an offset
+ * relative to the start of the image that holds the table.
+ */
+struct scene_cell_entry {
+  std::uint64_t offset, size;
+};
+
+static char const SCENE_FILE_MAGIC[8] = {'E', 'Z', 'G', 'L', 'S', 'C', 'N', '\0'};
+
+// Written in native byte order; a file from a machine with a different byte order is rejected
+static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static constexpr std::uint64_t SECTION_ALIGNMENT = 64;
+
+static std::uint64_t align_section(std::uint64_t offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// Check that a header describes a scene file of the given size whose sections can be used in place
+static bool validate_header(scene_file_header const &header, std::uint64_t file_size, const char *file_path)
+{
+  if(std::memcmp(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.byte_order != BYTE_ORDER_MARK) {
+    g_warning("scene: File %s is not a scene file.", file_path);
+    return false;
+  }
+
+  if(header.version != SCENE_FILE_VERSION) {
+    g_warning("scene: File %s has unsupported version %u.", file_path, header.version);
+    return false;
+  }
+
+  auto section_fits = [&](std::uint64_t offset, std::uint64_t count, std::size_t size) {
+    return offset % SECTION_ALIGNMENT == 0 && offset <= file_size && count <= (file_size - offset) / size;
+  };
+
+  if(!section_fits(header.style_offset, header.style_count, sizeof(scene_style)) ||
+      !section_fits(header.primitive_offset, header.primitive_count, sizeof(scene_primitive)) ||
+      !section_fits(header.point_offset, header.point_count, sizeof(point2d)) ||
+      !section_fits(header.node_offset, header.node_count, sizeof(scene_node)) ||
+      !section_fits(header.page_offset, header.page_count, sizeof(scene_page)) ||
+      !section_fits(header.transform_offset, header.transform_count, sizeof(scene_transform)) ||
+      !section_fits(header.cell_offset, header.cell_count, sizeof(scene_cell_entry)) ||
+      (header.primitive_count == 0) != (header.node_count == 0)) {
+    g_warning("scene: File %s is truncated or corrupt.", file_path);
+    return false;
+  }
+
+  return true;
+}
+
+// Check that the children of a node are in range (children are stored before their parent)
+static bool is_valid_node(scene_node const *nodes, std::uint64_t index, std::uint64_t primitive_count)
+{
+  std::uint64_t limit = nodes[index].level == 0 ? primitive_count : index;
+
+  return nodes[index].first <= limit && nodes[index].count <= limit - nodes[index].first &&
+         nodes[index].count <= SCENE_NODE_CAPACITY;
+}
+
+// Check that the children of a valid node are one level below it, so traversals terminate at the leaves
+static bool has_valid_children(scene_node const *nodes, std::uint64_t index)
+{
+  if(nodes[index].level == 0)
+    return true;
+
+  for(std::uint64_t i = nodes[index].first; i < nodes[index].first + nodes[index].count; ++i) {
+    if(nodes[i].level + 1 != nodes[index].level)
+      return false;
+  }
+
+  return true;
+}
+
+// The index is traversed without bounds checks, so validate the nodes from a level up and the page table once
+static bool validate_index(scene_file_header const &header,
+    scene_node const *nodes,
+    scene_page const *pages,
+    std::uint32_t first_page_node,
+    std::uint32_t min_level,
+    const char *file_path)
+{
+  // Traversals use a fixed-size stack, which bounds the height of the tree
+  bool valid = header.node_count == 0 || nodes[header.node_count - 1].level < 64;
+
+  for(std::uint64_t i = 0; i < header.node_count && valid; ++i) {
+    if(nodes[i].level >= min_level)
+      valid = is_valid_node(nodes, i, header.primitive_count) && has_valid_children(nodes, i);
+  }
+
+  if(!valid) {
+    g_warning("scene: File %s has a corrupt spatial index.", file_path);
+    return false;
+  }
+
+  // A tree is written with pages on the level of its root or below, and every node on the page level must be a page.
+  // A tree without pages would be traversed as if it were entirely resident, but only checked above the page level.
+  if((header.node_count > 0 && header.page_count == 0) ||
+      (first_page_node + header.page_count < header.node_count &&
+          nodes[first_page_node + header.page_count].level == header.page_level)) {
+    g_warning("scene: File %s has a corrupt page table.", file_path);
+    return false;
+  }
+
+  for(std::uint64_t i = 0; i < header.page_count; ++i) {
+    if(first_page_node + i >= header.node_count || nodes[first_page_node + i].level != header.page_level ||
+        pages[i].first_primitive > header.primitive_count ||
+        pages[i].primitive_count > header.primitive_count - pages[i].first_primitive ||
+        pages[i].first_point > header.point_count ||
+        pages[i].point_count > header.point_count - pages[i].first_point) {
+      g_warning("scene: File %s has a corrupt page table.", file_path);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// The ranges of the tables that primitives index into
+struct primitive_limits {
+  std::uint64_t style_count;
+  std::uint64_t first_point, end_point;
+  std::uint64_t transform_count;
+  std::uint64_t cell_count;
+};
+
+// Drawing indexes the style, point, transform and cell tables with the fields of primitives without bounds checks, so
+// check the primitives of a file before they are drawn
+static bool validate_primitives(scene_primitive const *primitives, std::uint64_t count, primitive_limits const &limits)
+{
+  for(std::uint64_t i = 0; i < count; ++i) {
+    scene_primitive const &p = primitives[i];
+
+    switch(p.kind) {
+    case primitive_kind::fill_rectangle:
+    case primitive_kind::rectangle:
+    case primitive_kind::line:
+      if(p.style >= limits.style_count)
+        return false;
+      break;
+    case primitive_kind::fill_poly:
+      if(p.style >= limits.style_count || p.num_points < 2 || p.first_point < limits.first_point ||
+          p.first_point > limits.end_point || p.num_points > limits.end_point - p.first_point)
+        return false;
+      break;
+    case primitive_kind::instance:
+      if(p.style >= limits.cell_count || p.first_point >= limits.transform_count)
+        return false;
+      break;
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Find the index of the first node of a level; nodes are stored level by level, starting with the leaves
+static std::uint32_t first_node_of_level(scene_node const *nodes, std::size_t node_count, std::uint32_t level)
+{
+  auto first = std::partition_point(
+      nodes, nodes + node_count, [level](scene_node const &node) { return node.level < level; });
+
+  return static_cast<std::uint32_t>(first - nodes);
+}
+
+// Find the range of primitives below a node. It is contiguous because primitives are stored in depth-first order.
+static void node_primitive_range(scene_node const *nodes,
+    std::uint32_t index,
+    std::uint64_t &first,
+    std::uint64_t &count)
+{
+  std::uint32_t leftmost = index;
+  while(nodes[leftmost].level > 0)
+    leftmost = nodes[leftmost].first;
+
+  std::uint32_t rightmost = index;
+  while(nodes[rightmost].level > 0)
+    rightmost = nodes[rightmost].first + nodes[rightmost].count - 1;
+
+  first = nodes[leftmost].first;
+  count = nodes[rightmost].first + nodes[rightmost].count - first;
+}
+
+#ifndef _WIN32
+// Tell the system how a range of mapped memory will be used. Memory is only discarded for the memory pages that lie
+// entirely inside the range, since the others are shared with neighbouring data.
+static void advise_memory(void const *start, std::size_t bytes, int advice)
+{
+  auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = reinterpret_cast<std::uintptr_t>(start);
+  auto end = begin + bytes;
+
+  if(advice == MADV_DONTNEED) {
+    begin = (begin + page_size - 1) / page_size * page_size;
+    end = end / page_size * page_size;
+  } else {
+    begin = begin / page_size * page_size;
+    end = (end + page_size - 1) / page_size * page_size;
+  }
+
+  if(end > begin)
+    madvise(reinterpret_cast<void *>(begin), end - begin, advice);
+}
+
+// Read exactly bytes bytes at offset
+static bool read_fully(int fd, void *destination, std::size_t bytes, std::uint64_t offset)
+{
+  auto out = static_cast<char *>(destination);
+
+  while(bytes > 0) {
+    ssize_t n = pread(fd, out, bytes, offset);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      return false;
+
+    out += n;
+    bytes -= n;
+    offset += n;
+  }
+
+  return true;
+}
+
+/**
+ * Reads the pages of a scene file into memory on a background thread.
+ *
+ * Primitives and vertices are read into an address range reserved for the whole file, so every primitive keeps its
+ * index from the file and the spatial index can be used unchanged. Memory is only committed for pages that have been
+ * read. The GTK thread decides which pages are wanted (set_focus) and which are dropped (release); it only reads a
+ * page after take_completed() has returned it, which orders the reads after the writes of the reader thread.
+ */
+class scene_stream_reader {
+public:
+  scene_stream_reader(int fd,
+      scene_file_header const &header,
+      std::vector<scene_page> const &pages,
+      std::size_t memory_budget)
+      : m_fd(fd), m_header(header), m_pages(pages), m_state(pages.size(), page_state::absent),
+        m_memory_budget(memory_budget)
+  {
+    m_primitive_bytes = header.primitive_count * sizeof(scene_primitive);
+    m_point_bytes = header.point_count * sizeof(point2d);
+
+    m_primitives = static_cast<scene_primitive *>(reserve(m_primitive_bytes));
+    m_points = static_cast<point2d *>(reserve(m_point_bytes));
+
+    if(is_valid())
+      m_thread = std::thread(&scene_stream_reader::run, this);
+  }
+
+  ~scene_stream_reader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+
+    if(m_thread.joinable())
+      m_thread.join();
+
+    if(m_primitives != nullptr)
+      munmap(m_primitives, m_primitive_bytes);
+    if(m_points != nullptr)
+      munmap(m_points, m_point_bytes);
+
+    close(m_fd);
+  }
+
+  scene_stream_reader(scene_stream_reader const &) = delete;
+  scene_stream_reader &operator=(scene_stream_reader const &) = delete;
+
+  bool is_valid() const
+  {
+    return (m_primitives != nullptr || m_primitive_bytes == 0) && (m_points != nullptr || m_point_bytes == 0);
+  }
+
+  scene_primitive const *primitives() const
+  {
+    return m_primitives;
+  }
+
+  point2d const *points() const
+  {
+    return m_points;
+  }
+
+  std::size_t memory_budget() const
+  {
+    return m_memory_budget;
+  }
+
+  // Read these pages first, in this order
+  void set_focus(std::vector<std::uint32_t> focus)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_focus = std::move(focus);
+    }
+    m_wake.notify_all();
+  }
+
+  // Collect the pages read since the last call
+  void take_completed(std::vector<std::uint32_t> &completed)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    completed.swap(m_completed);
+    m_completed.clear();
+
+    for(std::uint32_t page : completed)
+      m_state[page] = page_state::resident;
+    m_handed_over += completed.size();
+  }
+
+  // The number of bytes that must be released before the next wanted page can be read (0 if none)
+  std::size_t missing_memory()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_missing_bytes;
+  }
+
+  // Drop a resident page from memory; it will be read again if it is wanted later
+  void release(std::uint32_t page)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if(m_state[page] != page_state::resident)
+        return;
+
+      m_state[page] = page_state::absent;
+      m_resident_bytes -= page_bytes(page);
+      --m_handed_over;
+    }
+
+    scene_page const &p = m_pages[page];
+    advise_memory(m_primitives + p.first_primitive, p.primitive_count * sizeof(scene_primitive), MADV_DONTNEED);
+    advise_memory(m_points + p.first_point, p.point_count * sizeof(point2d), MADV_DONTNEED);
+
+    m_wake.notify_all();
+  }
+
+  // True once every page has been read and handed over
+  bool finished()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_handed_over + m_failed == m_pages.size();
+  }
+
+private:
+  enum class page_state : std::uint8_t { absent, reading, read, resident, failed };
+
+  static void *reserve(std::size_t bytes)
+  {
+    if(bytes == 0)
+      return nullptr;
+
+    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return memory == MAP_FAILED ? nullptr : memory;
+  }
+
+  std::size_t page_bytes(std::uint32_t page) const
+  {
+    return m_pages[page].primitive_count * sizeof(scene_primitive) + m_pages[page].point_count * sizeof(point2d);
+  }
+
+  // Choose the next page to read; called with the mutex held
+  bool next_page(std::uint32_t &page)
+  {
+    m_missing_bytes = 0;
+
+    for(std::uint32_t candidate : m_focus) {
+      if(m_state[candidate] != page_state::absent)
+        continue;
+
+      // A page larger than the whole budget is still read when nothing else is in memory
+      if(m_memory_budget > 0 && m_resident_bytes > 0 && m_resident_bytes + page_bytes(candidate) > m_memory_budget) {
+        m_missing_bytes = m_resident_bytes + page_bytes(candidate) - m_memory_budget;
+        return false;
+      }
+
+      page = candidate;
+      return true;
+    }
+
+    // Without a budget, read everything else in file order once the visible pages are in
+    if(m_memory_budget == 0) {
+      while(m_next_sequential < m_pages.size() && m_state[m_next_sequential] != page_state::absent)
+        ++m_next_sequential;
+
+      if(m_next_sequential < m_pages.size()) {
+        page = m_next_sequential;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(true) {
+      std::uint32_t page = 0;
+      m_wake.wait(lock, [&] { return m_stop || next_page(page); });
+
+      if(m_stop)
+        return;
+
+      m_state[page] = page_state::reading;
+      m_resident_bytes += page_bytes(page);
+      lock.unlock();
+
+      scene_page const &p = m_pages[page];
+      bool ok = read_fully(m_fd, m_primitives + p.first_primitive, p.primitive_count * sizeof(scene_primitive),
+                    m_header.primitive_offset + p.first_primitive * sizeof(scene_primitive)) &&
+                read_fully(m_fd, m_points + p.first_point, p.point_count * sizeof(point2d),
+                    m_header.point_offset + p.first_point * sizeof(point2d));
+
+      lock.lock();
+      if(ok) {
+        m_state[page] = page_state::read;
+        m_completed.push_back(page);
+      } else {
+        g_warning("scene::stream: Error reading page %u.", page);
+        m_state[page] = page_state::failed;
+        m_resident_bytes -= page_bytes(page);
+        ++m_failed;
+      }
+    }
+  }
+
+  // The file, and what it contains
+  int m_fd;
+  scene_file_header m_header;
+  std::vector<scene_page> m_pages;
+
+  // The reserved memory for all primitives and vertices
+  scene_primitive *m_primitives = nullptr;
+  point2d *m_points = nullptr;
+  std::size_t m_primitive_bytes = 0;
+  std::size_t m_point_bytes = 0;
+
+  // Everything below is protected by m_mutex
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<page_state> m_state;
+  std::vector<std::uint32_t> m_focus;
+  std::vector<std::uint32_t> m_completed;
+  std::size_t m_next_sequential = 0;
+  std::size_t m_handed_over = 0;
+  std::size_t m_failed = 0;
+  std::size_t m_memory_budget;
+  std::size_t m_resident_bytes = 0;
+  std::size_t m_missing_bytes = 0;
+  bool m_stop = false;
+
+  std::thread m_thread;
+};
+#else
+// Streaming falls back to scene::load on platforms without pread/mmap
+class scene_stream_reader {
+};
+#endif
+
+/**
+ * Sort items into the order of the Sort-Tile-Recursive packing: vertical slices sorted by x, each sorted by y.
+ * Consecutive runs of SCENE_NODE_CAPACITY items then form the nodes of the next level up.
+ */
+template <typename T, typename CenterX, typename CenterY>
+static void sort_tile_recursive(T *items, std::size_t count, CenterX center_x, CenterY center_y)
+{
+  std::size_t num_nodes = (count + SCENE_NODE_CAPACITY - 1) / SCENE_NODE_CAPACITY;
+  std::size_t num_slices = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(num_nodes))));
+  std::size_t slice_size = num_slices * SCENE_NODE_CAPACITY;
+
+  std::sort(items, items + count, [&](T const &a, T const &b) { return center_x(a) < center_x(b); });
+
+  for(std::size_t first = 0; first < count; first += slice_size) {
+    std::size_t last = std::min(first + slice_size, count);
+    std::sort(items + first, items + last, [&](T const &a, T const &b) { return center_y(a) < center_y(b); });
+  }
+}
+
+constexpr std::uint8_t scene::PAGE_UNCHECKED;
+constexpr std::uint8_t scene::PAGE_READY;
+constexpr std::uint8_t scene::PAGE_CORRUPT;
+constexpr std::uint32_t scene::NO_PALETTE;
+
+template <typename Visitor>
+void scene::visit_pages(rectangle const &region, Visitor &&visit)
+{
+  if(m_pages.empty())
+    return;
+
+  std::uint32_t stack[64 * SCENE_NODE_CAPACITY];
+  std::size_t top = 0;
+  stack[top++] = static_cast<std::uint32_t>(m_nodes.size() - 1);
+
+  while(top > 0) {
+    std::uint32_t index = stack[--top];
+    scene_node const &node = m_nodes[index];
+
+    if(!node.intersects(region))
+      continue;
+
+    if(node.level == m_page_level) {
+      if(index - m_first_page_node < m_pages.size())
+        visit(index - m_first_page_node);
+    } else if(node.level > m_page_level) {
+      for(std::uint32_t i = node.first; i < node.first + node.count; ++i)
+        stack[top++] = i;
+    }
+  }
+}
+
+scene_transform::scene_transform(point2d offset, cell_orientation orientation, double magnification)
+    : dx(offset.x), dy(offset.y)
+{
+  static int const cosines[4] = {1, 0, -1, 0};
+  static int const sines[4] = {0, 1, 0, -1};
+
+  auto code = static_cast<int>(orientation);
+  double c = cosines[code % 4] * magnification;
+  double s = sines[code % 4] * magnification;
+
+  // Mirroring about the x axis negates y before the rotation
+  double mirror = code >= 4 ? -1 : 1;
+
+  xx = c;
+  xy = -s * mirror;
+  yx = s;
+  yy = c * mirror;
+}
+
+scene_transform scene_transform::inverse() const
+{
+  double det = xx * yy - xy * yx;
+
+  scene_transform t;
+  t.xx = yy / det;
+  t.xy = -xy / det;
+  t.yx = -yx / det;
+  t.yy = xx / det;
+  t.dx = -(t.xx * dx + t.xy * dy);
+  t.dy = -(t.yx * dx + t.yy * dy);
+
+  return t;
+}
+
+scene_transform operator*(scene_transform const &outer, scene_transform const &inner)
+{
+  scene_transform t;
+  t.xx = outer.xx * inner.xx + outer.xy * inner.yx;
+  t.xy = outer.xx * inner.xy + outer.xy * inner.yy;
+  t.yx = outer.yx * inner.xx + outer.yy * inner.yx;
+  t.yy = outer.yx * inner.xy + outer.yy * inner.yy;
+  t.dx = outer.xx * inner.dx + outer.xy * inner.dy + outer.dx;
+  t.dy = outer.yx * inner.dx + outer.yy * inner.dy + outer.dy;
+
+  return t;
+}
+
+// The distance between a point and a line segment
+static double distance_to_segment(point2d p, point2d a, point2d b)
+{
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double length_squared = dx * dx + dy * dy;
+
+  double t = length_squared > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / length_squared : 0;
+  t = std::max(0.0, std::min(1.0, t));
+
+  return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+}
+
+// Identifies a cell raster: the cell and the linear part of its transform to pixels, which covers the zoom level, the
+// orientation and the magnification of the instance
+struct cell_raster_key {
+  std::uint32_t cell;
+  double xx, xy, yx, yy;
+
+  bool operator==(cell_raster_key const &other) const
+  {
+    return cell == other.cell && xx == other.xx && xy == other.xy && yx == other.yx && yy == other.yy;
+  }
+};
+
+struct cell_raster_key_hash {
+  std::size_t operator()(cell_raster_key const &key) const
+  {
+    std::size_t h = std::hash<std::uint32_t>()(key.cell);
+    for(double d : {key.xx, key.xy, key.yx, key.yy})
+      h = h * 31 + std::hash<double>()(d);
+
+    return h;
+  }
+};
+
+// A rasterized cell, and the position of its top-left corner relative to the cell's origin, in pixels
+struct cell_raster {
+  cairo_surface_t *surface;
+  double left, top;
+};
+
+/**
+ * The rasters of the cells of a scene.
+ */
+class cell_raster_cache : public lru_cache<cell_raster_key, cell_raster, cell_raster_key_hash> {
+public:
+  cell_raster_cache()
+      : lru_cache("cell rasters", 1.0, eviction_policy::lru, &default_cache_manager(),
+            [](cell_raster &raster) { cairo_surface_destroy(raster.surface); })
+  {
+  }
+};
+
+scene::scene()
+{
+}
+
+scene::~scene()
+{
+}
+
+std::uint32_t scene::add_style(color c, int line_width)
+{
+  std::vector<scene_style> &styles = m_styles.edit();
+  styles.push_back({c.red, c.green, c.blue, c.alpha, line_width});
+
+  return static_cast<std::uint32_t>(styles.size() - 1);
+}
+
+void scene::set_style_color(std::uint32_t style, color c)
+{
+  if(style >= m_styles.size()) {
+    g_warning("scene::set_style_color: Style %u does not exist.", style);
+    return;
+  }
+
+  scene_style &s = m_styles.edit()[style];
+  s.red = c.red;
+  s.green = c.green;
+  s.blue = c.blue;
+  s.alpha = c.alpha;
+
+  // Rasters of cells were drawn in the old colors
+  scene *root = m_owner != nullptr ? m_owner : this;
+  if(root->m_raster_cache)
+    root->m_raster_cache->clear();
+}
+
+bool scene::prepare_edit()
+{
+  if(is_streaming()) {
+    g_warning("scene: Primitives cannot be added while the scene is streaming.");
+    return false;
+  }
+
+  if(m_instanced) {
+    g_warning("scene: Primitives cannot be added to a cell that has been placed.");
+    return false;
+  }
+
+  // Every primitive is about to be copied to memory and indexed without pages, so they must all be valid
+  if(!check_all_pages()) {
+    g_warning("scene: Primitives cannot be added to a scene loaded from a corrupt file.");
+    return false;
+  }
+
+  // The arrays are about to be copied to memory, and the page cache only applies to the mapped file
+  m_page_cache.reset();
+
+  return true;
+}
+
+void scene::add_primitive(scene_primitive p)
+{
+  if(!prepare_edit())
+    return;
+
+  p.order = m_next_order++;
+  p.reserved[0] = p.reserved[1] = 0;
+
+  rectangle box = p.bounds();
+  if(m_primitives.empty()) {
+    m_bounds = box;
+  } else {
+    m_bounds = {{std::min(m_bounds.left(), box.left()), std::min(m_bounds.bottom(), box.bottom())},
+        {std::max(m_bounds.right(), box.right()), std::max(m_bounds.top(), box.top())}};
+  }
+
+  m_primitives.edit().push_back(p);
+  m_dirty = true;
+}
+
+void scene::add_fill_rectangle(rectangle r, std::uint32_t style, primitive_id id, std::uint8_t layer)
+{
+  add_primitive({r.left(), r.bottom(), r.right(), r.top(), id, style, 0, 0, 0,
+      primitive_kind::fill_rectangle, layer, {0, 0}});
+}
+
+void scene::add_rectangle(rectangle r, std::uint32_t style, primitive_id id, std::uint8_t layer)
+{
+  add_primitive({r.left(), r.bottom(), r.right(), r.top(), id, style, 0, 0, 0,
+      primitive_kind::rectangle, layer, {0, 0}});
+}
+
+void scene::add_line(point2d start, point2d end, std::uint32_t style, primitive_id id, std::uint8_t layer)
+{
+  add_primitive({start.x, start.y, end.x, end.y, id, style, 0, 0, 0, primitive_kind::line, layer, {0, 0}});
+}
+
+void scene::add_fill_poly(std::vector<point2d> const &points,
+    std::uint32_t style,
+    primitive_id id,
+    std::uint8_t layer)
+{
+  assert(points.size() > 1);
+
+  if(!prepare_edit())
+    return;
+
+  double x_min = points[0].x;
+  double x_max = points[0].x;
+  double y_min = points[0].y;
+  double y_max = points[0].y;
+
+  for(std::size_t i = 1; i < points.size(); ++i) {
+    x_min = std::min(x_min, points[i].x);
+    x_max = std::max(x_max, points[i].x);
+    y_min = std::min(y_min, points[i].y);
+    y_max = std::max(y_max, points[i].y);
+  }
+
+  std::vector<point2d> &pool = m_points.edit();
+  auto first_point = static_cast<std::uint32_t>(pool.size());
+  pool.insert(pool.end(), points.begin(), points.end());
+
+  add_primitive({x_min, y_min, x_max, y_max, id, style, first_point,
+      static_cast<std::uint32_t>(points.size()), 0, primitive_kind::fill_poly, layer, {0, 0}});
+}
+
+std::uint32_t scene::add_cell()
+{
+  if(m_owner != nullptr)
+    return m_owner->add_cell();
+
+  std::unique_ptr<scene> c(new scene());
+  c->m_owner = this;
+  c->m_cell_index = static_cast<std::uint32_t>(m_cells.size());
+  m_cells.push_back(std::move(c));
+
+  return m_cells.back()->m_cell_index;
+}
+
+scene &scene::cell(std::uint32_t index)
+{
+  scene &root = m_owner != nullptr ? *m_owner : *this;
+  assert(index < root.m_cells.size());
+
+  return *root.m_cells[index];
+}
+
+std::size_t scene::num_cells() const
+{
+  return m_owner != nullptr ? m_owner->m_cells.size() : m_cells.size();
+}
+
+void scene::add_instance(std::uint32_t cell_index, scene_transform const &placement, primitive_id id, std::uint8_t layer)
+{
+  // A cell can only place the cells defined before it, so the hierarchy has no cycles
+  scene &root = m_owner != nullptr ? *m_owner : *this;
+  std::size_t limit = m_owner != nullptr ? m_cell_index : root.m_cells.size();
+
+  if(cell_index >= limit) {
+    g_warning("scene::add_instance: Cell %u cannot be placed in this scene.", cell_index);
+    return;
+  }
+
+  if(!prepare_edit())
+    return;
+
+  scene &placed = *root.m_cells[cell_index];
+  placed.m_instanced = true;
+
+  std::vector<scene_transform> &transforms = m_transforms.edit();
+  transforms.push_back(placement);
+
+  rectangle box = placement.apply(placed.bounds());
+  add_primitive({box.left(), box.bottom(), box.right(), box.top(), id, cell_index,
+      static_cast<std::uint32_t>(transforms.size() - 1), 0, 0, primitive_kind::instance, layer, {0, 0}});
+}
+
+void scene::set_cell_raster_limit(std::size_t max_pixels)
+{
+  m_raster_limit = max_pixels;
+
+  if(m_raster_limit == 0)
+    m_raster_cache.reset();
+  else if(m_raster_cache == nullptr)
+    m_raster_cache.reset(new cell_raster_cache());
+}
+
+// Compute the union of rectangles as run-length spans: the maximal runs of each horizontal slab between consecutive
+// edges, combined with the runs of the next slab when they have the same extent
+static void union_spans(std::vector<rectangle> const &rects, std::vector<rectangle> &spans)
+{
+  std::vector<double> ys;
+  for(rectangle const &r : rects) {
+    ys.push_back(r.bottom());
+    ys.push_back(r.top());
+  }
+  std::sort(ys.begin(), ys.end());
+  ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+  std::vector<std::size_t> by_bottom(rects.size());
+  for(std::size_t i = 0; i < rects.size(); ++i)
+    by_bottom[i] = i;
+  std::sort(by_bottom.begin(), by_bottom.end(),
+      [&rects](std::size_t a, std::size_t b) { return rects[a].bottom() < rects[b].bottom(); });
+
+  std::vector<std::size_t> active;
+  std::vector<std::pair<double, double>> runs, open_runs;
+  std::vector<double> open_bottoms;
+  std::size_t next = 0;
+
+  for(std::size_t k = 0; k + 1 < ys.size(); ++k) {
+    double bottom = ys[k];
+
+    active.erase(std::remove_if(active.begin(), active.end(), [&](std::size_t i) { return rects[i].top() <= bottom; }),
+        active.end());
+    while(next < by_bottom.size() && rects[by_bottom[next]].bottom() <= bottom)
+      active.push_back(by_bottom[next++]);
+
+    // The union of the x extents of the rectangles spanning the slab
+    runs.clear();
+    for(std::size_t i : active)
+      runs.emplace_back(rects[i].left(), rects[i].right());
+    std::sort(runs.begin(), runs.end());
+
+    std::size_t merged = 0;
+    for(std::size_t i = 0; i < runs.size(); ++i) {
+      if(merged > 0 && runs[i].first <= runs[merged - 1].second)
+        runs[merged - 1].second = std::max(runs[merged - 1].second, runs[i].second);
+      else
+        runs[merged++] = runs[i];
+    }
+    runs.resize(merged);
+
+    if(runs == open_runs)
+      continue;
+
+    // The extent changed: close the runs of the previous slabs
+    for(std::size_t i = 0; i < open_runs.size(); ++i)
+      spans.push_back({{open_runs[i].first, open_bottoms[i]}, {open_runs[i].second, bottom}});
+
+    open_runs = runs;
+    open_bottoms.assign(runs.size(), bottom);
+  }
+
+  if(!ys.empty()) {
+    for(std::size_t i = 0; i < open_runs.size(); ++i)
+      spans.push_back({{open_runs[i].first, open_bottoms[i]}, {open_runs[i].second, ys.back()}});
+  }
+}
+
+std::size_t scene::merge_rectangles()
+{
+  // Merging edits every primitive, which would copy a file that is used in place (or only partly read) to memory
+  if(m_file != nullptr || m_stream != nullptr) {
+    g_warning("scene::merge_rectangles: Rectangles cannot be merged in a scene loaded from a file; merge them before "
+              "saving it.");
+    return 0;
+  }
+
+  if(!prepare_edit())
+    return 0;
+
+  std::vector<scene_primitive> &prims = m_primitives.edit();
+
+  // Group the filled rectangles by color, layer and id, in drawing order
+  std::map<std::tuple<std::uint32_t, std::uint8_t, primitive_id>, std::vector<std::size_t>> groups;
+  std::vector<scene_primitive> kept;
+
+  std::vector<std::size_t> by_order(prims.size());
+  for(std::size_t i = 0; i < prims.size(); ++i)
+    by_order[i] = i;
+  std::sort(by_order.begin(), by_order.end(),
+      [&prims](std::size_t a, std::size_t b) { return prims[a].order < prims[b].order; });
+
+  for(std::size_t i : by_order) {
+    scene_primitive const &p = prims[i];
+
+    if(p.kind != primitive_kind::fill_rectangle || p.style >= m_styles.size() || p.x0 == p.x1 || p.y0 == p.y1) {
+      kept.push_back(p);
+      continue;
+    }
+
+    scene_style const &style = m_styles[p.style];
+    std::uint32_t rgba = (std::uint32_t(style.red) << 24) | (std::uint32_t(style.green) << 16) |
+                         (std::uint32_t(style.blue) << 8) | style.alpha;
+    groups[std::make_tuple(rgba, p.layer, p.id)].push_back(i);
+  }
+
+  std::vector<rectangle> rects, spans;
+  for(auto const &group : groups) {
+    scene_primitive const &first = prims[group.second.front()];
+
+    rects.clear();
+    for(std::size_t i : group.second)
+      rects.push_back(prims[i].bounds());
+
+    spans.clear();
+    union_spans(rects, spans);
+
+    // Some overlaps (e.g., a cross) take more spans than rectangles; keep those groups as they are
+    if(spans.size() >= rects.size()) {
+      for(std::size_t i : group.second)
+        kept.push_back(prims[i]);
+      continue;
+    }
+
+    for(rectangle const &r : spans) {
+      kept.push_back({r.left(), r.bottom(), r.right(), r.top(), first.id, first.style, 0, 0, first.order,
+          primitive_kind::fill_rectangle, first.layer, {0, 0}});
+    }
+  }
+
+  std::size_t removed = prims.size() - kept.size();
+  prims.swap(kept);
+  m_dirty = true;
+
+  return removed;
+}
+
+void scene::clear()
+{
+  // Stop the reader and drop the page cache before releasing the memory the arrays refer to
+  m_stream.reset();
+  m_stream_done = false;
+  m_page_cache.reset();
+  m_last_view = rectangle();
+  m_page_resident.clear();
+  m_pages.clear();
+
+  // Cells refer to the file too
+  if(m_raster_cache)
+    m_raster_cache->clear();
+  m_cells.clear();
+
+  m_styles.clear();
+  m_points.clear();
+  m_primitives.clear();
+  m_nodes.clear();
+  m_transforms.clear();
+  m_file.reset();
+
+  m_bounds = rectangle();
+  m_next_order = 0;
+  m_dirty = false;
+  m_id_index_valid = false;
+}
+
+void scene::build()
+{
+  m_dirty = false;
+  m_id_index_valid = false;
+
+  // The pages of the file the scene came from no longer match the new index
+  m_page_cache.reset();
+  m_pages.clear();
+  m_page_resident.clear();
+
+  std::vector<scene_node> &nodes = m_nodes.edit();
+  nodes.clear();
+
+  if(m_primitives.empty())
+    return;
+
+  std::vector<scene_primitive> &prims = m_primitives.edit();
+
+  // Pack the primitives into leaves
+  sort_tile_recursive(prims.data(), prims.size(),
+      [](scene_primitive const &p) { return p.x0 + p.x1; },
+      [](scene_primitive const &p) { return p.y0 + p.y1; });
+
+  for(std::size_t first = 0; first < prims.size(); first += SCENE_NODE_CAPACITY) {
+    std::size_t last = std::min<std::size_t>(first + SCENE_NODE_CAPACITY, prims.size());
+
+    rectangle box = prims[first].bounds();
+    scene_node leaf = {box.left(), box.bottom(), box.right(), box.top(), static_cast<std::uint32_t>(first),
+        static_cast<std::uint32_t>(last - first), 0, 0};
+
+    for(std::size_t i = first + 1; i < last; ++i) {
+      box = prims[i].bounds();
+      leaf.x0 = std::min(leaf.x0, box.left());
+      leaf.y0 = std::min(leaf.y0, box.bottom());
+      leaf.x1 = std::max(leaf.x1, box.right());
+      leaf.y1 = std::max(leaf.y1, box.top());
+    }
+
+    nodes.push_back(leaf);
+  }
+
+  // Pack each level into the next one up until a single root remains
+  std::size_t level_first = 0;
+  std::uint32_t level = 0;
+
+  while(nodes.size() - level_first > 1) {
+    std::size_t level_last = nodes.size();
+
+    sort_tile_recursive(nodes.data() + level_first, level_last - level_first,
+        [](scene_node const &n) { return n.x0 + n.x1; },
+        [](scene_node const &n) { return n.y0 + n.y1; });
+
+    ++level;
+    for(std::size_t first = level_first; first < level_last; first += SCENE_NODE_CAPACITY) {
+      std::size_t last = std::min<std::size_t>(first + SCENE_NODE_CAPACITY, level_last);
+
+      scene_node parent = nodes[first];
+      parent.first = static_cast<std::uint32_t>(first);
+      parent.count = static_cast<std::uint32_t>(last - first);
+      parent.level = level;
+
+      for(std::size_t i = first + 1; i < last; ++i) {
+        parent.x0 = std::min(parent.x0, nodes[i].x0);
+        parent.y0 = std::min(parent.y0, nodes[i].y0);
+        parent.x1 = std::max(parent.x1, nodes[i].x1);
+        parent.y1 = std::max(parent.y1, nodes[i].y1);
+      }
+
+      nodes.push_back(parent);
+    }
+
+    level_first = level_last;
+  }
+
+  // Store the primitives in depth-first order so that every subtree covers a contiguous range of primitives
+  std::vector<scene_primitive> ordered;
+  ordered.reserve(prims.size());
+
+  std::vector<std::uint32_t> stack(1, static_cast<std::uint32_t>(nodes.size() - 1));
+  while(!stack.empty()) {
+    scene_node &node = nodes[stack.back()];
+    stack.pop_back();
+
+    if(node.level == 0) {
+      std::uint32_t first = static_cast<std::uint32_t>(ordered.size());
+      ordered.insert(ordered.end(), prims.begin() + node.first, prims.begin() + node.first + node.count);
+      node.first = first;
+    } else {
+      for(std::uint32_t i = node.first + node.count; i > node.first; --i)
+        stack.push_back(i - 1);
+    }
+  }
+
+  prims.swap(ordered);
+}
+
+void scene::draw_primitive(renderer *g,
+    scene_primitive const &p,
+    scene_style const *style,
+    point2d const *points,
+    std::vector<point2d> &scratch,
+    scene_transform const *to_target)
+{
+  if(p.kind == primitive_kind::instance)
+    return;
+
+  if(style != nullptr) {
+    g->set_color(style->color());
+    g->set_line_width(style->line_width);
+  }
+
+  auto place = [to_target](point2d q) { return to_target != nullptr ? to_target->apply(q) : q; };
+
+  switch(p.kind) {
+  case primitive_kind::fill_rectangle:
+    g->fill_rectangle(place({p.x0, p.y0}), place({p.x1, p.y1}));
+    break;
+  case primitive_kind::rectangle:
+    g->draw_rectangle(place({p.x0, p.y0}), place({p.x1, p.y1}));
+    break;
+  case primitive_kind::line:
+    g->draw_line(place({p.x0, p.y0}), place({p.x1, p.y1}));
+    break;
+  case primitive_kind::fill_poly:
+    scratch.resize(p.num_points);
+    for(std::uint32_t i = 0; i < p.num_points; ++i)
+      scratch[i] = place(points[p.first_point + i]);
+    g->fill_poly(scratch);
+    break;
+  case primitive_kind::instance:
+    break;
+  }
+}
+
+void scene::draw(renderer *g)
+{
+  if(m_dirty)
+    build();
+
+  if(m_primitives.empty())
+    return;
+
+  g->set_coordinate_system(WORLD);
+
+  rectangle visible_world = g->get_visible_world();
+  prepare_view(visible_world);
+
+  draw_region(g, visible_world, nullptr, *this, m_cells.size(), m_raster_cache != nullptr);
+}
+
+void scene::draw_ids(renderer *g, rectangle const &region, std::vector<primitive_id> &id_slots)
+{
+  if(m_dirty)
+    build();
+
+  if(m_primitives.empty())
+    return;
+
+  if(id_slots.empty())
+    id_slots.push_back(0);
+
+  g->set_coordinate_system(WORLD);
+
+  // Lines and outlines reach half their width beyond their bounding box, plus a pixel of rounding, so primitives just
+  // outside the region can cover pixels in it. The caller clips to the region.
+  std::int32_t line_width = 0;
+  for(scene_style const &style : m_styles)
+    line_width = std::max(line_width, style.line_width);
+  for(auto const &cell : m_cells) {
+    for(scene_style const &style : cell->m_styles)
+      line_width = std::max(line_width, style.line_width);
+  }
+
+  point2d world_per_pixel = g->m_camera->get_world_scale_factor();
+  double pad_x = (line_width / 2.0 + 1) * std::abs(world_per_pixel.x);
+  double pad_y = (line_width / 2.0 + 1) * std::abs(world_per_pixel.y);
+  rectangle reach = {{region.left() - pad_x, region.bottom() - pad_y}, {region.right() + pad_x, region.top() + pad_y}};
+
+  draw_region(g, reach, nullptr, *this, m_cells.size(), false, &id_slots);
+}
+
+void scene::update_palette_offsets()
+{
+  m_palette_offsets.resize(m_cells.size());
+
+  auto offset = static_cast<std::uint32_t>(m_styles.size());
+  for(std::size_t i = 0; i < m_cells.size(); ++i) {
+    m_palette_offsets[i] = offset;
+    offset += static_cast<std::uint32_t>(m_cells[i]->m_styles.size());
+  }
+}
+
+void scene::draw_style_indices(renderer *g, rectangle const &region)
+{
+  if(m_dirty)
+    build();
+
+  if(m_primitives.empty())
+    return;
+
+  update_palette_offsets();
+
+  g->set_coordinate_system(WORLD);
+  prepare_view(region);
+
+  draw_region(g, region, nullptr, *this, m_cells.size(), false, nullptr, nullptr, 0);
+}
+
+void scene::palette(std::vector<std::uint32_t> &lut)
+{
+  update_palette_offsets();
+
+  auto add_styles = [&lut](scene_array<scene_style> const &styles) {
+    for(scene_style const &s : styles) {
+      // Premultiplied by alpha, as cairo stores pixels
+      std::uint32_t a = s.alpha;
+      lut.push_back((a << 24) | ((s.red * a + 127) / 255 << 16) | ((s.green * a + 127) / 255 << 8) |
+                    (s.blue * a + 127) / 255);
+    }
+  };
+
+  lut.assign(1, 0);
+  add_styles(m_styles);
+  for(auto const &cell : m_cells)
+    add_styles(cell->m_styles);
+}
+
+void scene::draw_region(renderer *g,
+    rectangle const &region,
+    scene_transform const *to_target,
+    scene &root,
+    std::size_t cell_limit,
+    bool use_rasters,
+    std::vector<primitive_id> *id_slots,
+    color const *id_color,
+    std::uint32_t palette_base)
+{
+  // Cells are built when first drawn; building reorders the primitives
+  if(m_dirty)
+    build();
+
+  scene_primitive const *base = m_primitives.data();
+
+  m_visible.clear();
+  query(region, [&](scene_primitive const &p) {
+    m_visible.push_back(static_cast<std::uint32_t>(&p - base));
+  });
+
+  // The spatial index scrambles the primitives; restore layer and insertion order for overlapping primitives
+  std::sort(m_visible.begin(), m_visible.end(), [base](std::uint32_t a, std::uint32_t b) {
+    return base[a].layer < base[b].layer || (base[a].layer == base[b].layer && base[a].order < base[b].order);
+  });
+
+  // Only the top-level scene is culled, while drawing normally
+  if(m_occlusion_culling && to_target == nullptr && id_slots == nullptr && id_color == nullptr)
+    cull_occluded(g, region);
+
+  std::uint32_t current_style = UINT32_MAX;
+
+  for(std::uint32_t i : m_visible) {
+    scene_primitive const &p = base[i];
+
+    // In an ID pass, untagged primitives of the top-level scene are skipped and the others get a slot
+    color slot_color;
+    color const *flat_color = id_color;
+    if(id_slots != nullptr && id_color == nullptr) {
+      if(p.id == 0)
+        continue;
+
+      auto slot = static_cast<std::uint32_t>(id_slots->size());
+      id_slots->push_back(p.id);
+      slot_color = color((slot >> 16) & 0xFF, (slot >> 8) & 0xFF, slot & 0xFF);
+      flat_color = &slot_color;
+    }
+
+    if(p.kind == primitive_kind::instance) {
+      // Checked here rather than when loading, so that files with many instances load without reading them all
+      if(p.style >= cell_limit || p.first_point >= m_transforms.size())
+        continue;
+
+      scene_transform const &placement = m_transforms[p.first_point];
+      scene_transform to_cell_target = to_target != nullptr ? *to_target * placement : placement;
+
+      std::uint32_t cell_palette_base = palette_base != NO_PALETTE ? root.m_palette_offsets[p.style] : NO_PALETTE;
+
+      if(!use_rasters || !root.draw_cell_raster(g, p.style, to_cell_target)) {
+        root.m_cells[p.style]->draw_region(g, placement.inverse().apply(region), &to_cell_target, root, p.style,
+            use_rasters, id_slots, flat_color, cell_palette_base);
+      }
+
+      // The cell changed the renderer's attributes
+      current_style = UINT32_MAX;
+      continue;
+    }
+
+    // The ID, style index and highlight passes set their own colors; a normal draw applies styles as they change
+    scene_style const *style = nullptr;
+    if(palette_base != NO_PALETTE && flat_color == nullptr) {
+      if(p.style != current_style) {
+        current_style = p.style;
+
+        std::uint32_t index = palette_base + p.style + 1;
+        g->set_line_width(m_styles[p.style].line_width);
+        g->set_color((index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF);
+      }
+    } else if(flat_color != nullptr) {
+      g->set_line_width(m_styles[p.style].line_width);
+      g->set_color(*flat_color);
+      current_style = UINT32_MAX;
+    } else if(p.style != current_style) {
+      current_style = p.style;
+      style = &m_styles[p.style];
+    }
+
+    draw_primitive(g, p, style, m_points.data(), m_poly_points, to_target);
+  }
+}
+
+void scene::build_id_index()
+{
+  m_id_index.clear();
+  m_id_indexed_pages.clear();
+
+  // The ids of a loaded file can be read before its pages are checked, since only drawing relies on the other fields
+  if(m_page_resident.empty() || (!m_page_cache && !m_stream)) {
+    for(std::size_t i = 0; i < m_primitives.size(); ++i) {
+      if(m_primitives[i].id != 0)
+        m_id_index.emplace_back(m_primitives[i].id, static_cast<std::uint32_t>(i));
+    }
+  } else {
+    // Only pages that are ready are read from a paged or streamed scene; the others are added as they become ready
+    // (see index_page_ids)
+    m_id_indexed_pages.assign(m_pages.size(), 0);
+
+    for(std::uint32_t page = 0; page < m_pages.size(); ++page) {
+      if(m_page_resident[page] == PAGE_READY)
+        append_page_ids(page);
+    }
+  }
+
+  std::sort(m_id_index.begin(), m_id_index.end());
+  m_id_index_valid = true;
+}
+
+void scene::append_page_ids(std::uint32_t page)
+{
+  scene_page const &p = m_pages[page];
+
+  for(std::uint64_t i = p.first_primitive; i < p.first_primitive + p.primitive_count; ++i) {
+    if(m_primitives[i].id != 0)
+      m_id_index.emplace_back(m_primitives[i].id, static_cast<std::uint32_t>(i));
+  }
+
+  m_id_indexed_pages[page] = 1;
+}
+
+void scene::index_page_ids(std::uint32_t page)
+{
+  // Pages dropped by a streaming scene keep their entries, which lookups skip, so a page read again is not re-added
+  if(!m_id_index_valid || m_id_indexed_pages.empty() || m_id_indexed_pages[page] != 0)
+    return;
+
+  auto middle = static_cast<std::ptrdiff_t>(m_id_index.size());
+  append_page_ids(page);
+
+  std::sort(m_id_index.begin() + middle, m_id_index.end());
+  std::inplace_merge(m_id_index.begin(), m_id_index.begin() + middle, m_id_index.end());
+}
+
+std::uint32_t scene::page_of(std::uint32_t primitive) const
+{
+  auto after = std::upper_bound(m_pages.begin(), m_pages.end(), primitive,
+      [](std::uint32_t i, scene_page const &p) { return i < p.first_primitive; });
+
+  return static_cast<std::uint32_t>(after - m_pages.begin()) - 1;
+}
+
+bool scene::draw_highlight(renderer *g,
+    std::vector<primitive_id> const &ids,
+    scene_style const &style,
+    rectangle &bounds)
+{
+  if(m_dirty)
+    build();
+
+  if(!m_id_index_valid)
+    build_id_index();
+
+  scene_primitive const *base = m_primitives.data();
+
+  m_visible.clear();
+  for(primitive_id id : ids) {
+    auto range = std::equal_range(m_id_index.begin(), m_id_index.end(), std::make_pair(id, std::uint32_t(0)),
+        [](std::pair<primitive_id, std::uint32_t> const &a, std::pair<primitive_id, std::uint32_t> const &b) {
+          return a.first < b.first;
+        });
+
+    // Primitives of pages that are not ready (e.g., dropped by a streaming scene) are not read. The pages of a loaded
+    // file are checked on first use, which does not change m_id_index since it holds every page.
+    for(auto it = range.first; it != range.second; ++it) {
+      if(!m_page_resident.empty()) {
+        std::uint32_t page = page_of(it->second);
+        if(m_page_resident[page] == PAGE_UNCHECKED && !m_page_cache && !m_stream)
+          check_page(page);
+
+        if(m_page_resident[page] != PAGE_READY)
+          continue;
+      }
+
+      m_visible.push_back(it->second);
+    }
+  }
+
+  if(m_visible.empty())
+    return false;
+
+  std::sort(m_visible.begin(), m_visible.end(), [base](std::uint32_t a, std::uint32_t b) {
+    return base[a].layer < base[b].layer || (base[a].layer == base[b].layer && base[a].order < base[b].order);
+  });
+
+  g->set_coordinate_system(WORLD);
+  g->set_color(style.color());
+  g->set_line_width(style.line_width);
+
+  color const highlight = style.color();
+  bool found = false;
+
+  for(std::uint32_t i : m_visible) {
+    scene_primitive const &p = base[i];
+
+    if(p.kind == primitive_kind::instance) {
+      if(p.style >= m_cells.size() || p.first_point >= m_transforms.size())
+        continue;
+
+      scene_transform const &placement = m_transforms[p.first_point];
+      scene &c = *m_cells[p.style];
+      c.draw_region(g, c.bounds(), &placement, *this, p.style, false, nullptr, &highlight);
+
+      // The cell changed the renderer's attributes
+      g->set_color(highlight);
+      g->set_line_width(style.line_width);
+    } else {
+      draw_primitive(g, p, nullptr, m_points.data(), m_poly_points);
+    }
+
+    rectangle box = p.bounds();
+    if(!found) {
+      bounds = box;
+      found = true;
+    } else {
+      bounds = {{std::min(bounds.left(), box.left()), std::min(bounds.bottom(), box.bottom())},
+          {std::max(bounds.right(), box.right()), std::max(bounds.top(), box.top())}};
+    }
+  }
+
+  return found;
+}
+
+void scene::cull_occluded(renderer *g, rectangle const &region)
+{
+  m_occlusion_stats = scene_occlusion_stats();
+  m_occlusion_stats.visible = m_visible.size();
+
+  point2d world_per_pixel = g->m_camera->get_world_scale_factor();
+  double pixel_width = std::abs(world_per_pixel.x);
+  double pixel_height = std::abs(world_per_pixel.y);
+  double block_width = SCENE_OCCLUSION_BLOCK * pixel_width;
+  double block_height = SCENE_OCCLUSION_BLOCK * pixel_height;
+
+  if(!(block_width > 0) || !(block_height > 0) || region.width() <= 0 || region.height() <= 0)
+    return;
+
+  auto columns = static_cast<std::ptrdiff_t>(std::ceil(region.width() / block_width));
+  auto rows = static_cast<std::ptrdiff_t>(std::ceil(region.height() / block_height));
+
+  // The mask would be larger than the screen; the camera is not showing the region
+  if(columns * rows > (1 << 24))
+    return;
+
+  m_occlusion_mask.assign(static_cast<std::size_t>(columns * rows), 0);
+
+  double screen_area = (region.width() / pixel_width) * (region.height() / pixel_height);
+  double area_before = 0;
+  double area_after = 0;
+
+  // The blocks a box overlaps, clamped to the mask
+  auto block_range = [&](double low, double high, double origin, double size, std::ptrdiff_t count,
+                         std::ptrdiff_t &first, std::ptrdiff_t &last) {
+    first = std::max<std::ptrdiff_t>(0, static_cast<std::ptrdiff_t>(std::floor((low - origin) / size)));
+    last = std::min<std::ptrdiff_t>(count - 1, static_cast<std::ptrdiff_t>(std::floor((high - origin) / size)));
+  };
+
+  // The blocks completely inside a box, clamped to the mask
+  auto inner_range = [&](double low, double high, double origin, double size, std::ptrdiff_t count,
+                         std::ptrdiff_t &first, std::ptrdiff_t &last) {
+    first = std::max<std::ptrdiff_t>(0, static_cast<std::ptrdiff_t>(std::ceil((low - origin) / size)));
+    last = std::min<std::ptrdiff_t>(count - 1, static_cast<std::ptrdiff_t>(std::floor((high - origin) / size)) - 1);
+  };
+
+  scene_primitive const *base = m_primitives.data();
+
+  // Front to back: everything drawn after a primitive has been seen when it is tested
+  for(auto it = m_visible.rbegin(); it != m_visible.rend(); ++it) {
+    scene_primitive const &p = base[*it];
+
+    // Lines and outlines reach half their width beyond their bounding box, and antialiasing one more pixel
+    double pad = 1;
+    if(p.kind != primitive_kind::instance && p.kind != primitive_kind::fill_rectangle && p.style < m_styles.size())
+      pad += m_styles[p.style].line_width / 2.0;
+
+    rectangle box = p.bounds();
+    double left = std::max(box.left() - pad * pixel_width, region.left());
+    double right = std::min(box.right() + pad * pixel_width, region.right());
+    double bottom = std::max(box.bottom() - pad * pixel_height, region.bottom());
+    double top = std::min(box.top() + pad * pixel_height, region.top());
+
+    double area = std::max(0.0, right - left) / pixel_width * std::max(0.0, top - bottom) / pixel_height;
+    area_before += area;
+
+    std::ptrdiff_t first_column, last_column, first_row, last_row;
+    block_range(left, right, region.left(), block_width, columns, first_column, last_column);
+    block_range(bottom, top, region.bottom(), block_height, rows, first_row, last_row);
+
+    bool hidden = first_column <= last_column && first_row <= last_row;
+    for(std::ptrdiff_t row = first_row; hidden && row <= last_row; ++row) {
+      for(std::ptrdiff_t column = first_column; column <= last_column; ++column) {
+        if(m_occlusion_mask[row * columns + column] == 0) {
+          hidden = false;
+          break;
+        }
+      }
+    }
+
+    if(hidden) {
+      *it = UINT32_MAX;
+      ++m_occlusion_stats.culled;
+      continue;
+    }
+
+    area_after += area;
+
+    // Opaque filled rectangles cover the blocks that are completely inside them
+    if(p.kind != primitive_kind::fill_rectangle || p.style >= m_styles.size() || m_styles[p.style].alpha != 255)
+      continue;
+
+    inner_range(box.left(), box.right(), region.left(), block_width, columns, first_column, last_column);
+    inner_range(box.bottom(), box.top(), region.bottom(), block_height, rows, first_row, last_row);
+
+    for(std::ptrdiff_t row = first_row; row <= last_row; ++row) {
+      for(std::ptrdiff_t column = first_column; column <= last_column; ++column)
+        m_occlusion_mask[row * columns + column] = 1;
+    }
+  }
+
+  m_visible.erase(std::remove(m_visible.begin(), m_visible.end(), UINT32_MAX), m_visible.end());
+
+  m_occlusion_stats.overdraw_before = area_before / screen_area;
+  m_occlusion_stats.overdraw_after = area_after / screen_area;
+}
+
+primitive_id scene::pick(point2d point, double tolerance)
+{
+  scene_primitive const *p = find_topmost(point, tolerance, *this, m_cells.size(), true);
+
+  return p != nullptr ? p->id : 0;
+}
+
+scene_primitive const *
+scene::find_topmost(point2d point, double tolerance, scene &root, std::size_t cell_limit, bool tagged_only)
+{
+  if(m_dirty)
+    build();
+
+  scene_primitive const *best = nullptr;
+
+  query({{point.x - tolerance, point.y - tolerance}, {point.x + tolerance, point.y + tolerance}},
+      [&](scene_primitive const &p) {
+        if(tagged_only && p.id == 0)
+          return;
+
+        if(best != nullptr && (p.layer < best->layer || (p.layer == best->layer && p.order < best->order)))
+          return;
+
+        if(hit_test(p, point, tolerance, root, cell_limit))
+          best = &p;
+      });
+
+  return best;
+}
+
+bool scene::hit_test(scene_primitive const &p, point2d point, double tolerance, scene &root, std::size_t cell_limit)
+{
+  switch(p.kind) {
+  case primitive_kind::fill_rectangle:
+    // The query already found the point within the tolerance of the bounding box
+    return true;
+  case primitive_kind::rectangle: {
+    rectangle b = p.bounds();
+    return point.x <= b.left() + tolerance || point.x >= b.right() - tolerance || point.y <= b.bottom() + tolerance ||
+           point.y >= b.top() - tolerance;
+  }
+  case primitive_kind::line:
+    return distance_to_segment(point, {p.x0, p.y0}, {p.x1, p.y1}) <= tolerance;
+  case primitive_kind::fill_poly: {
+    if(p.num_points == 0 || std::size_t(p.first_point) + p.num_points > m_points.size())
+      return false;
+
+    // Even-odd rule, or near an edge
+    bool inside = false;
+    point2d const *v = m_points.data() + p.first_point;
+    for(std::uint32_t i = 0, j = p.num_points - 1; i < p.num_points; j = i++) {
+      if((v[i].y > point.y) != (v[j].y > point.y) &&
+          point.x < (v[j].x - v[i].x) * (point.y - v[i].y) / (v[j].y - v[i].y) + v[i].x)
+        inside = !inside;
+
+      if(tolerance > 0 && distance_to_segment(point, v[j], v[i]) <= tolerance)
+        return true;
+    }
+
+    return inside;
+  }
+  case primitive_kind::instance: {
+    if(p.style >= cell_limit || p.first_point >= m_transforms.size())
+      return false;
+
+    // Search the cell in its own coordinates, scaling the tolerance by the placement's magnification
+    scene_transform const &placement = m_transforms[p.first_point];
+    double magnification = std::sqrt(std::abs(placement.xx * placement.yy - placement.xy * placement.yx));
+
+    return root.m_cells[p.style]->find_topmost(
+               placement.inverse().apply(point), tolerance / magnification, root, p.style, false) != nullptr;
+  }
+  }
+
+  return false;
+}
+
+bool scene::draw_cell_raster(renderer *g, std::uint32_t cell_index, scene_transform const &to_world)
+{
+  scene &c = *m_cells[cell_index];
+
+  // The linear part of the transform from cell coordinates to pixels; the screen's y axis points down
+  point2d world_per_pixel = g->m_camera->get_world_scale_factor();
+  scene_transform to_pixels = to_world;
+  to_pixels.xx /= world_per_pixel.x;
+  to_pixels.xy /= world_per_pixel.x;
+  to_pixels.yx /= -world_per_pixel.y;
+  to_pixels.yy /= -world_per_pixel.y;
+  to_pixels.dx = 0;
+  to_pixels.dy = 0;
+
+  rectangle extent = to_pixels.apply(c.bounds());
+  double left = std::floor(extent.left());
+  double top = std::floor(extent.bottom());
+  double width = std::ceil(extent.right()) - left;
+  double height = std::ceil(extent.top()) - top;
+
+  if(width < 1 || height < 1 || width * height > m_raster_limit)
+    return false;
+
+  cell_raster_key key = {cell_index, to_pixels.xx, to_pixels.xy, to_pixels.yx, to_pixels.yy};
+  cell_raster *raster = m_raster_cache->find(key);
+
+  if(raster == nullptr) {
+    cairo_surface_t *surface =
+        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, static_cast<int>(width), static_cast<int>(height));
+    if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(surface);
+      return false;
+    }
+
+    // Draw the whole cell in pixel coordinates, without rasters of nested cells
+    cairo_t *context = cairo_create(surface);
+    {
+      renderer raster_renderer(context, g->m_transform, g->m_camera, surface);
+      raster_renderer.set_coordinate_system(SCREEN);
+
+      to_pixels.dx = -left;
+      to_pixels.dy = -top;
+      c.draw_region(&raster_renderer, c.bounds(), &to_pixels, *this, cell_index, false);
+    }
+    cairo_destroy(context);
+    cairo_surface_flush(surface);
+
+    raster = m_raster_cache->insert(key, {surface, left, top}, static_cast<std::size_t>(width * height) * 4);
+  }
+
+  // The raster's corner is at a fixed pixel offset from the cell's origin
+  point2d origin = g->m_transform(to_world.apply({0, 0}));
+
+  cairo_save(g->m_cairo);
+  cairo_set_source_surface(g->m_cairo, raster->surface, std::round(origin.x + raster->left),
+      std::round(origin.y + raster->top));
+  cairo_paint(g->m_cairo);
+  cairo_restore(g->m_cairo);
+
+  return true;
+}
+
+// Write count zero bytes
+static bool write_padding(FILE *file, std::uint64_t count)
+{
+  static char const zeros[SECTION_ALIGNMENT] = {0};
+
+  return count == 0 || std::fwrite(zeros, 1, count, file) == count;
+}
+
+bool scene::save(const char *file_path)
+{
+  if(m_dirty)
+    build();
+
+  if(is_streaming()) {
+    g_warning("scene::save: The scene cannot be saved while it is streaming.");
+    return false;
+  }
+
+  // Writing the image reads the vertices of every polygon
+  if(!check_all_pages()) {
+    g_warning("scene::save: The scene was loaded from a corrupt file.");
+    return false;
+  }
+
+  FILE *file = std::fopen(file_path, "wb");
+  if(file == nullptr) {
+    g_warning("scene::save: Could not create file %s.", file_path);
+    return false;
+  }
+
+  bool ok = write_image(file);
+  ok = (std::fclose(file) == 0) && ok;
+
+  if(!ok)
+    g_warning("scene::save: Error writing file %s.", file_path);
+
+  return ok;
+}
+
+std::uint64_t scene::layout_image(scene_file_header &header, std::vector<scene_page> &pages)
+{
+  if(m_dirty)
+    build();
+
+  // Polygon vertices are written in primitive order, so the vertices of nearby primitives are nearby in the file
+  std::uint64_t num_points = 0;
+  for(scene_primitive const &p : m_primitives) {
+    if(p.kind == primitive_kind::fill_poly)
+      num_points += p.num_points;
+  }
+
+  // Each page is a subtree of the index near the leaves. Pages are stored in node order, which is also primitive
+  // order, so their vertex ranges follow from one sweep over the primitives.
+  pages.clear();
+  std::uint32_t page_level = 0;
+
+  if(!m_nodes.empty()) {
+    page_level = std::min(SCENE_PAGE_LEVEL, m_nodes[m_nodes.size() - 1].level);
+
+    std::uint64_t next_point = 0;
+    std::uint64_t next_primitive = 0;
+    for(std::uint32_t i = first_node_of_level(m_nodes.data(), m_nodes.size(), page_level);
+        i < m_nodes.size() && m_nodes[i].level == page_level; ++i) {
+      scene_page page;
+      node_primitive_range(m_nodes.data(), i, page.first_primitive, page.primitive_count);
+
+      for(; next_primitive < page.first_primitive + page.primitive_count; ++next_primitive) {
+        if(m_primitives[next_primitive].kind == primitive_kind::fill_poly)
+          next_point += m_primitives[next_primitive].num_points;
+      }
+
+      page.point_count = next_point;
+      pages.push_back(page);
+    }
+
+    // Convert the running totals into ranges
+    std::uint64_t first_point = 0;
+    for(scene_page &page : pages) {
+      page.first_point = first_point;
+      page.point_count -= first_point;
+      first_point += page.point_count;
+    }
+  }
+
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic));
+  header.version = SCENE_FILE_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.style_count = m_styles.size();
+  header.primitive_count = m_primitives.size();
+  header.point_count = num_points;
+  header.node_count = m_nodes.size();
+  header.page_count = pages.size();
+  header.transform_count = m_transforms.size();
+  header.cell_count = m_cells.size();
+  header.style_offset = align_section(sizeof(header));
+  header.primitive_offset = align_section(header.style_offset + header.style_count * sizeof(scene_style));
+  header.point_offset = align_section(header.primitive_offset + header.primitive_count * sizeof(scene_primitive));
+  header.node_offset = align_section(header.point_offset + header.point_count * sizeof(point2d));
+  header.page_offset = align_section(header.node_offset + header.node_count * sizeof(scene_node));
+  header.transform_offset = align_section(header.page_offset + header.page_count * sizeof(scene_page));
+  header.cell_offset = align_section(header.transform_offset + header.transform_count * sizeof(scene_transform));
+  header.page_level = page_level;
+  header.bounds[0] = m_bounds.left();
+  header.bounds[1] = m_bounds.bottom();
+  header.bounds[2] = m_bounds.right();
+  header.bounds[3] = m_bounds.top();
+  header.next_order = m_next_order;
+
+  // The images of the cells follow the cell table
+  std::uint64_t size = header.cell_offset + header.cell_count * sizeof(scene_cell_entry);
+  for(auto &cell : m_cells) {
+    scene_file_header cell_header;
+    std::vector<scene_page> cell_pages;
+    size = align_section(size) + cell->layout_image(cell_header, cell_pages);
+  }
+
+  return size;
+}
+
+bool scene::write_image(std::FILE *file)
+{
+  scene_file_header header;
+  std::vector<scene_page> pages;
+  layout_image(header, pages);
+
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+  std::uint64_t position = sizeof(header);
+  auto write_section = [&](std::uint64_t offset, void const *data, std::size_t size, std::size_t count) {
+    ok = ok && write_padding(file, offset - position);
+    ok = ok && (count == 0 || std::fwrite(data, size, count, file) == count);
+    position = offset + size * count;
+  };
+
+  write_section(header.style_offset, m_styles.data(), sizeof(scene_style), m_styles.size());
+
+  // Write the primitives in blocks, renumbering polygon vertices as they go
+  ok = ok && write_padding(file, header.primitive_offset - position);
+  std::vector<scene_primitive> block;
+  block.reserve(4096);
+  std::uint32_t next_point = 0;
+
+  for(std::size_t i = 0; i < m_primitives.size() && ok; ++i) {
+    block.push_back(m_primitives[i]);
+    if(block.back().kind == primitive_kind::fill_poly) {
+      block.back().first_point = next_point;
+      next_point += block.back().num_points;
+    }
+
+    if(block.size() == block.capacity() || i + 1 == m_primitives.size()) {
+      ok = std::fwrite(block.data(), sizeof(scene_primitive), block.size(), file) == block.size();
+      block.clear();
+    }
+  }
+  position = header.primitive_offset + header.primitive_count * sizeof(scene_primitive);
+
+  ok = ok && write_padding(file, header.point_offset - position);
+  for(std::size_t i = 0; i < m_primitives.size() && ok; ++i) {
+    scene_primitive const &p = m_primitives[i];
+    if(p.kind == primitive_kind::fill_poly)
+      ok = std::fwrite(m_points.data() + p.first_point, sizeof(point2d), p.num_points, file) == p.num_points;
+  }
+  position = header.point_offset + header.point_count * sizeof(point2d);
+
+  write_section(header.node_offset, m_nodes.data(), sizeof(scene_node), m_nodes.size());
+  write_section(header.page_offset, pages.data(), sizeof(scene_page), pages.size());
+  write_section(header.transform_offset, m_transforms.data(), sizeof(scene_transform), m_transforms.size());
+
+  // The cell table, then the cells
+  std::vector<scene_cell_entry> cells;
+  std::uint64_t cell_position = header.cell_offset + header.cell_count * sizeof(scene_cell_entry);
+  for(auto &cell : m_cells) {
+    scene_file_header cell_header;
+    std::vector<scene_page> cell_pages;
+    scene_cell_entry entry;
+    entry.offset = align_section(cell_position);
+    entry.size = cell->layout_image(cell_header, cell_pages);
+    cells.push_back(entry);
+    cell_position = entry.offset + entry.size;
+  }
+
+  write_section(header.cell_offset, cells.data(), sizeof(scene_cell_entry), cells.size());
+
+  for(std::size_t i = 0; i < m_cells.size() && ok; ++i) {
+    ok = write_padding(file, cells[i].offset - position) && m_cells[i]->write_image(file);
+    position = cells[i].offset + cells[i].size;
+  }
+
+  return ok;
+}
+
+bool scene::load(const char *file_path)
+{
+  return open_file(file_path);
+}
+
+bool scene::load_paged(const char *file_path, double cache_weight)
+{
+  if(!open_file(file_path))
+    return false;
+
+  if(m_pages.empty())
+    return true;
+
+#ifndef _WIN32
+  // Pages are requested explicitly, so reading ahead of every fault would only waste memory
+  advise_memory(m_file->data(), m_file->size(), MADV_RANDOM);
+#endif
+
+  m_page_cache.reset(new lru_cache<std::uint32_t, std::uint32_t>("scene pages", cache_weight,
+      eviction_policy::lru, &default_cache_manager(), [this](std::uint32_t &page) { advise_page(page, false); }));
+
+  return true;
+}
+
+bool scene::open_file(const char *file_path)
+{
+  clear();
+
+  if(m_owner != nullptr) {
+    g_warning("scene::load: Files can only be loaded into a top-level scene.");
+    return false;
+  }
+
+  std::unique_ptr<mapped_file> file(new mapped_file(file_path));
+  if(!file->is_open()) {
+    g_warning("scene::load: Could not open file %s.", file_path);
+    return false;
+  }
+
+  if(!map_image(file->data(), file->size(), file_path)) {
+    clear();
+    return false;
+  }
+
+  m_file = std::move(file);
+
+  // The pages are checked the first time they are used (see require_pages)
+  m_page_resident.assign(m_pages.size(), PAGE_UNCHECKED);
+
+  return true;
+}
+
+bool scene::map_image(unsigned char const *data, std::size_t size, const char *file_path)
+{
+  scene_file_header header;
+  if(size < sizeof(header)) {
+    g_warning("scene::load: File %s is not a scene file.", file_path);
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if(!validate_header(header, size, file_path))
+    return false;
+
+  // Cells cannot have cells of their own
+  if(m_owner != nullptr && header.cell_count > 0) {
+    g_warning("scene::load: File %s has a corrupt cell table.", file_path);
+    return false;
+  }
+
+  auto nodes = reinterpret_cast<scene_node const *>(data + header.node_offset);
+  auto pages = reinterpret_cast<scene_page const *>(data + header.page_offset);
+  std::uint32_t first_page_node = first_node_of_level(nodes, header.node_count, header.page_level);
+
+  // A top-level scene validates the nodes and primitives below its pages when they are first used, so opening it
+  // only reads the index above them. Cells are small, and are validated as a whole.
+  bool whole = m_owner != nullptr;
+  if(!validate_index(header, nodes, pages, first_page_node, whole ? 0 : header.page_level, file_path))
+    return false;
+
+  if(!map_cells(data, size, header, file_path))
+    return false;
+
+  // Cells may only place the cells before them
+  primitive_limits const limits = {header.style_count, 0, header.point_count, header.transform_count,
+      whole ? m_cell_index : header.cell_count};
+  if(whole && !validate_primitives(reinterpret_cast<scene_primitive const *>(data + header.primitive_offset),
+                  header.primitive_count, limits)) {
+    g_warning("scene: File %s has corrupt primitives.", file_path);
+    return false;
+  }
+
+  m_styles.map(reinterpret_cast<scene_style const *>(data + header.style_offset), header.style_count);
+  m_primitives.map(reinterpret_cast<scene_primitive const *>(data + header.primitive_offset), header.primitive_count);
+  m_points.map(reinterpret_cast<point2d const *>(data + header.point_offset), header.point_count);
+  m_nodes.map(nodes, header.node_count);
+  m_transforms.map(
+      reinterpret_cast<scene_transform const *>(data + header.transform_offset), header.transform_count);
+  m_pages.assign(pages, pages + header.page_count);
+  m_page_level = header.page_level;
+  m_first_page_node = first_page_node;
+
+  m_bounds = {{header.bounds[0], header.bounds[1]}, {header.bounds[2], header.bounds[3]}};
+  m_next_order = header.next_order;
+
+  return true;
+}
+
+bool scene::map_cells(unsigned char const *data,
+    std::size_t size,
+    scene_file_header const &header,
+    const char *file_path)
+{
+  auto cells = reinterpret_cast<scene_cell_entry const *>(data + header.cell_offset);
+
+  for(std::uint64_t i = 0; i < header.cell_count; ++i) {
+    if(cells[i].offset % SECTION_ALIGNMENT != 0 || cells[i].offset > size || cells[i].size > size - cells[i].offset) {
+      g_warning("scene::load: File %s has a corrupt cell table.", file_path);
+      return false;
+    }
+
+    std::unique_ptr<scene> c(new scene());
+    c->m_owner = this;
+    c->m_cell_index = static_cast<std::uint32_t>(i);
+    c->m_instanced = true;
+
+    if(!c->map_image(data + cells[i].offset, cells[i].size, file_path))
+      return false;
+
+    m_cells.push_back(std::move(c));
+  }
+
+  return true;
+}
+
+bool scene::stream(const char *file_path, std::size_t memory_budget)
+{
+#ifdef _WIN32
+  (void)memory_budget;
+
+  return load(file_path);
+#else
+  clear();
+
+  if(m_owner != nullptr) {
+    g_warning("scene::stream: Files can only be loaded into a top-level scene.");
+    return false;
+  }
+
+  int fd = open(file_path, O_RDONLY);
+  if(fd < 0) {
+    g_warning("scene::stream: Could not open file %s.", file_path);
+    return false;
+  }
+
+  // The header, styles, index and page table are small; read them now and leave the rest to the reader thread
+  struct stat file_stat;
+  scene_file_header header;
+  if(fstat(fd, &file_stat) != 0 || static_cast<std::uint64_t>(file_stat.st_size) < sizeof(header) ||
+      !read_fully(fd, &header, sizeof(header), 0)) {
+    g_warning("scene::stream: File %s is not a scene file.", file_path);
+    close(fd);
+    return false;
+  }
+
+  if(!validate_header(header, file_stat.st_size, file_path)) {
+    close(fd);
+    return false;
+  }
+
+  std::vector<scene_style> &styles = m_styles.edit();
+  std::vector<scene_node> &nodes = m_nodes.edit();
+  std::vector<scene_transform> &transforms = m_transforms.edit();
+  styles.resize(header.style_count);
+  nodes.resize(header.node_count);
+  transforms.resize(header.transform_count);
+  m_pages.resize(header.page_count);
+
+  bool ok = read_fully(fd, styles.data(), styles.size() * sizeof(scene_style), header.style_offset) &&
+            read_fully(fd, nodes.data(), nodes.size() * sizeof(scene_node), header.node_offset) &&
+            read_fully(fd, m_pages.data(), m_pages.size() * sizeof(scene_page), header.page_offset) &&
+            read_fully(fd, transforms.data(), transforms.size() * sizeof(scene_transform), header.transform_offset);
+
+  // Cells are expected to be small compared to the scene, so they are mapped rather than streamed
+  if(ok && header.cell_count > 0) {
+    std::unique_ptr<mapped_file> file(new mapped_file(file_path));
+    ok = file->is_open() && file->size() == static_cast<std::size_t>(file_stat.st_size) &&
+         map_cells(file->data(), file->size(), header, file_path);
+    m_file = std::move(file);
+  }
+
+  std::uint32_t first_page_node = first_node_of_level(nodes.data(), nodes.size(), header.page_level);
+
+  if(!ok || !validate_index(header, nodes.data(), m_pages.data(), first_page_node, 0, file_path)) {
+    if(!ok)
+      g_warning("scene::stream: Error reading file %s.", file_path);
+    close(fd);
+    clear();
+    return false;
+  }
+
+  // The reader owns the descriptor from here on
+  std::unique_ptr<scene_stream_reader> reader(new scene_stream_reader(fd, header, m_pages, memory_budget));
+  if(!reader->is_valid()) {
+    g_warning("scene::stream: Could not reserve memory for file %s.", file_path);
+    reader.reset();
+    clear();
+    return false;
+  }
+
+  m_primitives.map(reader->primitives(), header.primitive_count);
+  m_points.map(reader->points(), header.point_count);
+  m_page_level = header.page_level;
+  m_first_page_node = first_page_node;
+  m_page_resident.assign(m_pages.size(), PAGE_UNCHECKED);
+
+  m_bounds = {{header.bounds[0], header.bounds[1]}, {header.bounds[2], header.bounds[3]}};
+  m_next_order = header.next_order;
+  m_stream = std::move(reader);
+
+  // Start with the whole scene in focus, until the first draw narrows it down
+  m_stream_focus = rectangle();
+  focus_stream(m_bounds);
+
+  return true;
+#endif
+}
+
+bool scene::is_streaming() const
+{
+#ifdef _WIN32
+  return false;
+#else
+  return m_stream != nullptr && !m_page_resident.empty() && !m_stream_done;
+#endif
+}
+
+bool scene::update_stream(rectangle &updated_region)
+{
+#ifdef _WIN32
+  (void)updated_region;
+
+  return false;
+#else
+  if(!is_streaming())
+    return false;
+
+  std::vector<std::uint32_t> completed;
+  m_stream->take_completed(completed);
+
+  bool updated = false;
+  for(std::uint32_t page : completed) {
+    scene_node const &node = m_nodes[m_first_page_node + page];
+
+    if(updated) {
+      updated_region = {{std::min(updated_region.left(), node.x0), std::min(updated_region.bottom(), node.y0)},
+          {std::max(updated_region.right(), node.x1), std::max(updated_region.top(), node.y1)}};
+    } else {
+      updated_region = {{node.x0, node.y0}, {node.x1, node.y1}};
+      updated = true;
+    }
+
+    check_page(page);
+  }
+
+  // With a memory budget, make room for visible pages by dropping the resident pages farthest from the view
+  std::size_t missing = m_stream->missing_memory();
+  if(missing > 0) {
+    point2d focus_center = m_stream_focus.center();
+
+    std::vector<std::pair<double, std::uint32_t>> candidates;
+    for(std::uint32_t page = 0; page < m_page_resident.size(); ++page) {
+      scene_node const &node = m_nodes[m_first_page_node + page];
+      if(m_page_resident[page] != PAGE_READY || node.intersects(m_stream_focus))
+        continue;
+
+      double dx = (node.x0 + node.x1) / 2 - focus_center.x;
+      double dy = (node.y0 + node.y1) / 2 - focus_center.y;
+      candidates.emplace_back(dx * dx + dy * dy, page);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<double, std::uint32_t>>());
+
+    for(std::size_t i = 0; i < candidates.size() && missing > 0; ++i) {
+      std::uint32_t page = candidates[i].second;
+      std::size_t released = m_pages[page].primitive_count * sizeof(scene_primitive) +
+                             m_pages[page].point_count * sizeof(point2d);
+
+      m_page_resident[page] = PAGE_UNCHECKED;
+      m_stream->release(page);
+      missing -= std::min(missing, released);
+    }
+  }
+
+  // Once everything is in memory the scene behaves like a loaded one, unless pages that failed to read or validate
+  // must still be skipped
+  if(m_stream->memory_budget() == 0 && m_stream->finished()) {
+    m_stream_done = true;
+
+    auto unusable = [](std::uint8_t state) { return state != PAGE_READY; };
+    if(std::none_of(m_page_resident.begin(), m_page_resident.end(), unusable))
+      m_page_resident.clear();
+  }
+
+  return updated;
+#endif
+}
+
+void scene::focus_stream(rectangle const &region)
+{
+#ifndef _WIN32
+  if(!is_streaming() || region == m_stream_focus)
+    return;
+
+  m_stream_focus = region;
+
+  // Read the pages nearest the centre of the view first
+  point2d center = region.center();
+  std::vector<std::pair<double, std::uint32_t>> visible;
+  visit_pages(region, [&](std::uint32_t page) {
+    scene_node const &node = m_nodes[m_first_page_node + page];
+
+    double dx = (node.x0 + node.x1) / 2 - center.x;
+    double dy = (node.y0 + node.y1) / 2 - center.y;
+    visible.emplace_back(dx * dx + dy * dy, page);
+  });
+
+  std::sort(visible.begin(), visible.end());
+
+  std::vector<std::uint32_t> focus;
+  focus.reserve(visible.size());
+  for(auto const &entry : visible)
+    focus.push_back(entry.second);
+
+  m_stream->set_focus(std::move(focus));
+#else
+  (void)region;
+#endif
+}
+
+std::size_t scene::advise_page(std::uint32_t page, bool needed)
+{
+  scene_page const &p = m_pages[page];
+  std::size_t bytes = p.primitive_count * sizeof(scene_primitive) + p.point_count * sizeof(point2d);
+
+#ifndef _WIN32
+  int advice = needed ? MADV_WILLNEED : MADV_DONTNEED;
+  advise_memory(m_primitives.data() + p.first_primitive, p.primitive_count * sizeof(scene_primitive), advice);
+  advise_memory(m_points.data() + p.first_point, p.point_count * sizeof(point2d), advice);
+#endif
+
+  // The nodes below a page are contiguous on each level. They may not have been validated yet, so check as we go.
+  std::uint32_t left = m_first_page_node + page;
+  std::uint32_t right = left;
+  for(std::uint32_t level = m_page_level; level > 0; --level) {
+    if(!is_valid_node(m_nodes.data(), left, m_primitives.size()) ||
+        !is_valid_node(m_nodes.data(), right, m_primitives.size()) || m_nodes[right].count == 0)
+      break;
+
+    left = m_nodes[left].first;
+    right = m_nodes[right].first + m_nodes[right].count - 1;
+    if(right < left || right >= m_nodes.size())
+      break;
+
+    bytes += (right - left + 1) * sizeof(scene_node);
+
+#ifndef _WIN32
+    advise_memory(&m_nodes[left], (right - left + 1) * sizeof(scene_node), advice);
+#endif
+  }
+
+  return bytes;
+}
+
+void scene::require_pages(rectangle const &region)
+{
+  bool checked = false;
+
+  visit_pages(region, [&](std::uint32_t page) {
+    if(m_page_cache && m_page_cache->find(page) == nullptr)
+      m_page_cache->insert(page, page, advise_page(page, true));
+
+    // Validate the page the first time it is used
+    if(m_page_resident[page] != PAGE_UNCHECKED)
+      return;
+
+    check_page(page);
+    checked = true;
+  });
+
+  // Once every page of a loaded file is checked, it is used like a scene built in memory unless pages must be skipped
+  auto unusable = [](std::uint8_t state) { return state != PAGE_READY; };
+  if(checked && !m_page_cache && std::none_of(m_page_resident.begin(), m_page_resident.end(), unusable))
+    m_page_resident.clear();
+}
+
+void scene::check_page(std::uint32_t page)
+{
+  m_page_resident[page] = validate_page(page) ? PAGE_READY : PAGE_CORRUPT;
+
+  if(m_page_resident[page] == PAGE_READY)
+    index_page_ids(page);
+}
+
+bool scene::check_all_pages()
+{
+  // The pages a stream has not handed over are not in memory
+  for(std::uint32_t page = 0; page < m_page_resident.size() && !m_stream; ++page) {
+    if(m_page_resident[page] == PAGE_UNCHECKED)
+      check_page(page);
+  }
+
+  auto unusable = [](std::uint8_t state) { return state != PAGE_READY; };
+  return std::none_of(m_page_resident.begin(), m_page_resident.end(), unusable);
+}
+
+bool scene::validate_page(std::uint32_t page)
+{
+  scene_page const &p = m_pages[page];
+  primitive_limits const limits = {
+      m_styles.size(), p.first_point, p.first_point + p.point_count, m_transforms.size(), m_cells.size()};
+
+  std::vector<std::uint32_t> stack(1, m_first_page_node + page);
+  while(!stack.empty()) {
+    std::uint32_t index = stack.back();
+    stack.pop_back();
+
+    if(!is_valid_node(m_nodes.data(), index, m_primitives.size()) || !has_valid_children(m_nodes.data(), index)) {
+      g_warning("scene: Page %u of the scene has a corrupt spatial index.", page);
+      return false;
+    }
+
+    scene_node const &node = m_nodes[index];
+
+    if(node.level > 0) {
+      for(std::uint32_t i = node.first; i < node.first + node.count; ++i)
+        stack.push_back(i);
+      continue;
+    }
+
+    // The leaves must stay within the page, which is all a streamed scene has read
+    if(node.first < p.first_primitive || node.first + node.count > p.first_primitive + p.primitive_count ||
+        !validate_primitives(m_primitives.data() + node.first, node.count, limits)) {
+      g_warning("scene: Page %u of the scene has corrupt primitives.", page);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void scene::prepare_view(rectangle const &visible)
+{
+  if(m_stream)
+    focus_stream(visible);
+
+  if(m_page_cache)
+    prefetch_pages(visible);
+}
+
+void scene::prefetch_pages(rectangle const &visible)
+{
+  // Look half a view around the visible world, and further in the direction the view last moved
+  point2d motion = m_last_view.area() > 0 ? visible.center() - m_last_view.center() : point2d{0, 0};
+  double margin_x = visible.width() / 2;
+  double margin_y = visible.height() / 2;
+
+  rectangle ahead = {{visible.left() - margin_x + std::min(motion.x, 0.0),
+                         visible.bottom() - margin_y + std::min(motion.y, 0.0)},
+      {visible.right() + margin_x + std::max(motion.x, 0.0), visible.top() + margin_y + std::max(motion.y, 0.0)}};
+
+  m_last_view = visible;
+
+  // Visible pages are requested by the query that follows, after these, so they are the most recently used
+  visit_pages(ahead, [&](std::uint32_t page) {
+    if(!m_page_cache->contains(page) && !m_nodes[m_first_page_node + page].intersects(visible))
+      m_page_cache->insert(page, page, advise_page(page, true));
+  });
+}
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/series.hpp"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ezgl {
+
+struct series::column_state {
+  // The pixel columns, in world coordinates
+  double left;
+  double width;
+  long long first_column;
+  long long last_column;
+
+  // The column being accumulated
+  bool open = false;
+  long long column = 0;
+  double first_x = 0, first_y = 0;
+  double last_x = 0, last_y = 0;
+  double min = 0, max = 0;
+
+  // The last sample of the previous column
+  bool has_previous = false;
+  double previous_x = 0, previous_y = 0;
+
+  // The column of an x coordinate; samples outside of the view fall just outside of the first or last column
+  long long column_of(double x) const
+  {
+    double c = std::floor((x - left) / width);
+    return static_cast<long long>(std::min<double>(std::max<double>(c, first_column - 1), last_column + 1));
+  }
+};
+
+series::series(double const *x, double const *y, std::size_t count)
+{
+  assign(x, y, count);
+}
+
+bool series::assign(double const *x, double const *y, std::size_t count)
+{
+  m_x.clear();
+  m_y.clear();
+  m_levels.clear();
+  m_bounds = rectangle();
+
+  for(std::size_t i = 1; i < count; ++i) {
+    if(x[i] < x[i - 1]) {
+      g_warning("series::assign: The x coordinates decrease at sample %zu.", i);
+      return false;
+    }
+  }
+
+  if(count == 0)
+    return true;
+
+  m_x.assign(x, x + count);
+  m_y.assign(y, y + count);
+
+  auto y_range = std::minmax_element(m_y.begin(), m_y.end());
+  m_bounds = {{m_x.front(), *y_range.first}, {m_x.back(), *y_range.second}};
+
+  // Each level aggregates SERIES_FANOUT blocks of the level below, until a level has a single block
+  std::size_t blocks = count;
+  while(blocks > 1) {
+    std::size_t next = (blocks + SERIES_FANOUT - 1) / SERIES_FANOUT;
+    std::vector<extent> level(next);
+
+    for(std::size_t b = 0; b < next; ++b) {
+      std::size_t first = b * SERIES_FANOUT;
+      std::size_t last = std::min(first + SERIES_FANOUT, blocks);
+
+      extent e = {INFINITY, -INFINITY};
+      for(std::size_t i = first; i < last; ++i) {
+        if(m_levels.empty()) {
+          e.min = std::min(e.min, m_y[i]);
+          e.max = std::max(e.max, m_y[i]);
+        } else {
+          e.min = std::min(e.min, m_levels.back()[i].min);
+          e.max = std::max(e.max, m_levels.back()[i].max);
+        }
+      }
+
+      level[b] = e;
+    }
+
+    m_levels.push_back(std::move(level));
+    blocks = next;
+  }
+
+  return true;
+}
+
+void series::add_block(column_state &column, std::size_t first, std::size_t last, extent const &e)
+{
+  long long c = column.column_of(m_x[first]);
+
+  if(!column.open || c != column.column) {
+    finish_column(column);
+
+    column.open = true;
+    column.column = c;
+    column.first_x = m_x[first];
+    column.first_y = m_y[first];
+    column.min = e.min;
+    column.max = e.max;
+  } else {
+    column.min = std::min(column.min, e.min);
+    column.max = std::max(column.max, e.max);
+  }
+
+  column.last_x = m_x[last - 1];
+  column.last_y = m_y[last - 1];
+}
+
+void series::finish_column(column_state &column)
+{
+  if(!column.open)
+    return;
+
+  if(column.has_previous)
+    m_segments.push_back({{column.previous_x, column.previous_y}, {column.first_x, column.first_y}});
+
+  if(column.min < column.max) {
+    double x = column.left + (column.column + 0.5) * column.width;
+    m_segments.push_back({{x, column.min}, {x, column.max}});
+  }
+
+  column.has_previous = true;
+  column.previous_x = column.last_x;
+  column.previous_y = column.last_y;
+  column.open = false;
+}
+
+void series::draw(renderer *g)
+{
+  if(m_x.empty())
+    return;
+
+  g->set_coordinate_system(WORLD);
+
+  rectangle world = g->get_visible_world();
+  double columns = std::max(1.0, std::round(g->get_visible_screen().width()));
+
+  column_state column;
+  column.left = world.left();
+  column.width = world.width() / columns;
+  column.first_column = 0;
+  column.last_column = static_cast<long long>(columns) - 1;
+
+  if(!(column.width > 0))
+    return;
+
+  // The visible samples, and one more on each side so the line reaches the edges of the view
+  std::size_t first = std::lower_bound(m_x.begin(), m_x.end(), world.left()) - m_x.begin();
+  std::size_t last = std::upper_bound(m_x.begin(), m_x.end(), world.right()) - m_x.begin();
+  if(first > 0)
+    --first;
+  if(last < m_x.size())
+    ++last;
+
+  m_segments.clear();
+
+  for(std::size_t i = first; i < last;) {
+    // Take the largest aligned block starting at i that is within the range and in a single column
+    std::size_t level = 0;
+    std::size_t block = 1;
+
+    for(std::size_t k = 0; k < m_levels.size(); ++k) {
+      std::size_t size = block * SERIES_FANOUT;
+      if(i % size != 0 || i + size > last || column.column_of(m_x[i]) != column.column_of(m_x[i + size - 1]))
+        break;
+
+      level = k + 1;
+      block = size;
+    }
+
+    extent e = level == 0 ? extent{m_y[i], m_y[i]} : m_levels[level - 1][i / block];
+    add_block(column, i, i + block, e);
+
+    i += block;
+  }
+
+  finish_column(column);
+
+  g->draw_lines(m_segments);
+}
+}
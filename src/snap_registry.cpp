@@ -0,0 +1,144 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/snap_registry.hpp"
+
+#include <algorithm>
+
+namespace ezgl {
+
+// Points added since the last build are searched linearly until there are this many, or 1/8 of the tree's size
+static constexpr std::size_t MIN_REBUILD_POINTS = 256;
+
+static double coordinate(point2d p, int axis)
+{
+  return axis == 0 ? p.x : p.y;
+}
+
+void snap_registry::clear()
+{
+  m_points.clear();
+  m_axes.clear();
+  m_built = 0;
+}
+
+void snap_registry::build()
+{
+  m_axes.resize(m_points.size());
+  build(0, m_points.size());
+  m_built = m_points.size();
+}
+
+void snap_registry::build(std::size_t first, std::size_t last)
+{
+  // The node of the range [first, last) is its middle point; its children are the ranges on either side
+  while(last - first > 1) {
+    double x_min = m_points[first].position.x, x_max = x_min;
+    double y_min = m_points[first].position.y, y_max = y_min;
+
+    for(std::size_t i = first + 1; i < last; ++i) {
+      x_min = std::min(x_min, m_points[i].position.x);
+      x_max = std::max(x_max, m_points[i].position.x);
+      y_min = std::min(y_min, m_points[i].position.y);
+      y_max = std::max(y_max, m_points[i].position.y);
+    }
+
+    int axis = x_max - x_min >= y_max - y_min ? 0 : 1;
+    std::size_t middle = first + (last - first) / 2;
+
+    std::nth_element(m_points.begin() + first, m_points.begin() + middle, m_points.begin() + last,
+        [axis](snap_point const &a, snap_point const &b) {
+          return coordinate(a.position, axis) < coordinate(b.position, axis);
+        });
+    m_axes[middle] = static_cast<std::uint8_t>(axis);
+
+    // Recurse into the smaller side and loop on the larger one
+    if(middle - first < last - middle - 1) {
+      build(first, middle);
+      first = middle + 1;
+    } else {
+      build(middle + 1, last);
+      last = middle;
+    }
+  }
+
+  if(last - first == 1)
+    m_axes[first] = 0;
+}
+
+void snap_registry::search(std::size_t first,
+    std::size_t last,
+    point2d position,
+    snap_point const *&best,
+    double &best_distance) const
+{
+  while(first < last) {
+    std::size_t middle = first + (last - first) / 2;
+    snap_point const &p = m_points[middle];
+
+    double dx = p.position.x - position.x;
+    double dy = p.position.y - position.y;
+    double distance = dx * dx + dy * dy;
+    if(distance <= best_distance) {
+      best = &p;
+      best_distance = distance;
+    }
+
+    // Search the side of the split containing the position first; the other side only if it can be close enough
+    int axis = m_axes[middle];
+    double offset = coordinate(position, axis) - coordinate(p.position, axis);
+
+    std::size_t near_first = offset < 0 ? first : middle + 1;
+    std::size_t near_last = offset < 0 ? middle : last;
+    std::size_t far_first = offset < 0 ? middle + 1 : first;
+    std::size_t far_last = offset < 0 ? last : middle;
+
+    search(near_first, near_last, position, best, best_distance);
+
+    if(offset * offset > best_distance)
+      return;
+
+    first = far_first;
+    last = far_last;
+  }
+}
+
+snap_point const *snap_registry::nearest(point2d position, double max_distance)
+{
+  if(m_points.size() - m_built > std::max(MIN_REBUILD_POINTS, m_built / 8))
+    build();
+
+  snap_point const *best = nullptr;
+  double best_distance = max_distance * max_distance;
+
+  for(std::size_t i = m_built; i < m_points.size(); ++i) {
+    double dx = m_points[i].position.x - position.x;
+    double dy = m_points[i].position.y - position.y;
+    double distance = dx * dx + dy * dy;
+
+    if(distance <= best_distance) {
+      best = &m_points[i];
+      best_distance = distance;
+    }
+  }
+
+  search(0, m_built, position, best, best_distance);
+
+  return best;
+}
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/tile_grid.hpp"
+
+#include "ezgl/graphics.hpp"
+
+#include <glib.h>
+
+#include <cassert>
+#include <cmath>
+
+namespace ezgl {
+
+tile_grid::tile_grid(point2d origin, double tile_width, double tile_height, int columns, int rows)
+    : m_origin(origin)
+    , m_tile_width(tile_width)
+    , m_tile_height(tile_height)
+    , m_columns(std::max(columns, 0))
+    , m_rows(std::max(rows, 0))
+{
+  assert(tile_width > 0 && tile_height > 0);
+}
+
+bool tile_grid::tile_at(point2d point, int &column, int &row) const
+{
+  double x = std::floor((point.x - m_origin.x) / m_tile_width);
+  double y = std::floor((point.y - m_origin.y) / m_tile_height);
+
+  if(x < 0 || x >= m_columns || y < 0 || y >= m_rows)
+    return false;
+
+  column = static_cast<int>(x);
+  row = static_cast<int>(y);
+
+  return true;
+}
+
+bool tile_grid::tile_range(rectangle const &region,
+    int &first_column,
+    int &last_column,
+    int &first_row,
+    int &last_row) const
+{
+  // Tiles whose primitives overhang into the region are visible too
+  double left = std::floor((region.left() - m_overhang_x - m_origin.x) / m_tile_width);
+  double right = std::floor((region.right() + m_overhang_x - m_origin.x) / m_tile_width);
+  double bottom = std::floor((region.bottom() - m_overhang_y - m_origin.y) / m_tile_height);
+  double top = std::floor((region.top() + m_overhang_y - m_origin.y) / m_tile_height);
+
+  if(right < 0 || left >= m_columns || top < 0 || bottom >= m_rows)
+    return false;
+
+  first_column = static_cast<int>(std::max(left, 0.0));
+  last_column = static_cast<int>(std::min<double>(right, m_columns - 1));
+  first_row = static_cast<int>(std::max(bottom, 0.0));
+  last_row = static_cast<int>(std::min<double>(top, m_rows - 1));
+
+  return true;
+}
+
+std::uint32_t tile_grid::add_style(color c, int line_width)
+{
+  m_styles.push_back({c.red, c.green, c.blue, c.alpha, line_width});
+
+  return static_cast<std::uint32_t>(m_styles.size() - 1);
+}
+
+void tile_grid::add_primitive(int column, int row, scene_primitive p)
+{
+  if(column < 0 || column >= m_columns || row < 0 || row >= m_rows) {
+    g_warning("tile_grid: Tile (%d, %d) is outside of the grid.", column, row);
+    return;
+  }
+
+  rectangle tile = tile_bounds(column, row);
+  rectangle box = p.bounds();
+
+  m_overhang_x = std::max({m_overhang_x, tile.left() - box.left(), box.right() - tile.right()});
+  m_overhang_y = std::max({m_overhang_y, tile.bottom() - box.bottom(), box.top() - tile.top()});
+
+  p.order = static_cast<std::uint32_t>(m_primitives.size());
+  p.reserved[0] = p.reserved[1] = 0;
+
+  m_primitives.push_back(p);
+  m_tiles.push_back(static_cast<std::uint32_t>(row) * m_columns + column);
+  m_dirty = true;
+}
+
+void tile_grid::add_fill_rectangle(int column,
+    int row,
+    rectangle r,
+    std::uint32_t style,
+    primitive_id id,
+    std::uint8_t layer)
+{
+  add_primitive(column, row, {r.left(), r.bottom(), r.right(), r.top(), id, style, 0, 0, 0,
+      primitive_kind::fill_rectangle, layer, {0, 0}});
+}
+
+void tile_grid::add_rectangle(int column, int row, rectangle r, std::uint32_t style, primitive_id id, std::uint8_t layer)
+{
+  add_primitive(column, row, {r.left(), r.bottom(), r.right(), r.top(), id, style, 0, 0, 0,
+      primitive_kind::rectangle, layer, {0, 0}});
+}
+
+void tile_grid::add_line(int column,
+    int row,
+    point2d start,
+    point2d end,
+    std::uint32_t style,
+    primitive_id id,
+    std::uint8_t layer)
+{
+  add_primitive(column, row, {start.x, start.y, end.x, end.y, id, style, 0, 0, 0, primitive_kind::line, layer, {0, 0}});
+}
+
+void tile_grid::add_fill_poly(int column,
+    int row,
+    std::vector<point2d> const &points,
+    std::uint32_t style,
+    primitive_id id,
+    std::uint8_t layer)
+{
+  assert(points.size() > 1);
+
+  double x_min = points[0].x;
+  double x_max = points[0].x;
+  double y_min = points[0].y;
+  double y_max = points[0].y;
+
+  for(std::size_t i = 1; i < points.size(); ++i) {
+    x_min = std::min(x_min, points[i].x);
+    x_max = std::max(x_max, points[i].x);
+    y_min = std::min(y_min, points[i].y);
+    y_max = std::max(y_max, points[i].y);
+  }
+
+  auto first_point = static_cast<std::uint32_t>(m_points.size());
+  m_points.insert(m_points.end(), points.begin(), points.end());
+
+  add_primitive(column, row, {x_min, y_min, x_max, y_max, id, style, first_point,
+      static_cast<std::uint32_t>(points.size()), 0, primitive_kind::fill_poly, layer, {0, 0}});
+}
+
+void tile_grid::clear()
+{
+  m_styles.clear();
+  m_points.clear();
+  m_primitives.clear();
+  m_tiles.clear();
+  m_layers.clear();
+  m_tile_start.clear();
+  m_overhang_x = 0;
+  m_overhang_y = 0;
+  m_dirty = false;
+}
+
+void tile_grid::build()
+{
+  m_dirty = false;
+
+  // Number the layers in use
+  bool used[256] = {};
+  for(scene_primitive const &p : m_primitives)
+    used[p.layer] = true;
+
+  std::uint32_t slot_of_layer[256];
+  m_layers.clear();
+  for(int layer = 0; layer < 256; ++layer) {
+    if(used[layer]) {
+      slot_of_layer[layer] = static_cast<std::uint32_t>(m_layers.size());
+      m_layers.push_back(static_cast<std::uint8_t>(layer));
+    }
+  }
+
+  // Counting sort by (layer, tile); stable, so insertion order is kept within each tile
+  std::size_t tiles = static_cast<std::size_t>(m_columns) * m_rows;
+  auto key = [&](std::size_t i) { return slot_of_layer[m_primitives[i].layer] * tiles + m_tiles[i]; };
+
+  m_tile_start.assign(m_layers.size() * tiles + 1, 0);
+  for(std::size_t i = 0; i < m_primitives.size(); ++i)
+    ++m_tile_start[key(i) + 1];
+
+  for(std::size_t k = 1; k < m_tile_start.size(); ++k)
+    m_tile_start[k] += m_tile_start[k - 1];
+
+  std::vector<std::uint32_t> next(m_tile_start.begin(), m_tile_start.end() - 1);
+  std::vector<scene_primitive> sorted(m_primitives.size());
+  std::vector<std::uint32_t> sorted_tiles(m_tiles.size());
+
+  for(std::size_t i = 0; i < m_primitives.size(); ++i) {
+    std::uint32_t destination = next[key(i)]++;
+    sorted[destination] = m_primitives[i];
+    sorted_tiles[destination] = m_tiles[i];
+  }
+
+  m_primitives.swap(sorted);
+  m_tiles.swap(sorted_tiles);
+}
+
+void tile_grid::draw(renderer *g)
+{
+  g->set_coordinate_system(WORLD);
+
+  std::uint32_t current_style = UINT32_MAX;
+
+  visit_ranges(g->get_visible_world(), [&](std::uint32_t first, std::uint32_t last) {
+    for(std::uint32_t i = first; i < last; ++i) {
+      scene_primitive const &p = m_primitives[i];
+
+      // The style is only set when it changes
+      scene_style const *style = nullptr;
+      if(p.style != current_style) {
+        current_style = p.style;
+        style = &m_styles[current_style];
+      }
+
+      scene::draw_primitive(g, p, style, m_points.data(), m_poly_points);
+    }
+  });
+}
+}
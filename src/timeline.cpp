@@ -0,0 +1,182 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+#include "ezgl/timeline.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace ezgl {
+
+timeline::timeline(double row_height, double row_fill) : m_row_height(row_height), m_row_fill(row_fill)
+{
+  assert(row_height > 0);
+}
+
+void timeline::add(std::uint32_t row, double start, double end, packed_color c, primitive_id id)
+{
+  if(end < start)
+    std::swap(start, end);
+
+  if(row >= m_rows.size())
+    m_rows.resize(row + 1);
+
+  if(m_size == 0) {
+    m_start = start;
+    m_end = end;
+  } else {
+    m_start = std::min(m_start, start);
+    m_end = std::max(m_end, end);
+  }
+
+  m_rows[row].intervals.push_back({start, end, c, id});
+  m_rows[row].dirty = true;
+  m_dirty = true;
+  ++m_size;
+}
+
+void timeline::clear()
+{
+  m_rows.clear();
+  m_size = 0;
+  m_dirty = false;
+}
+
+rectangle timeline::bounds() const
+{
+  if(m_size == 0)
+    return rectangle();
+
+  return {{m_start, 0}, {m_end, m_rows.size() * m_row_height}};
+}
+
+void timeline::build()
+{
+  m_dirty = false;
+
+  for(row &r : m_rows) {
+    if(!r.dirty)
+      continue;
+
+    r.dirty = false;
+
+    std::stable_sort(r.intervals.begin(), r.intervals.end(),
+        [](timeline_interval const &a, timeline_interval const &b) { return a.start < b.start; });
+
+    std::size_t blocks = (r.intervals.size() + TIMELINE_BLOCK - 1) / TIMELINE_BLOCK;
+    r.block_end.assign(blocks, -INFINITY);
+    r.prefix_end.assign(blocks, -INFINITY);
+
+    for(std::size_t i = 0; i < r.intervals.size(); ++i) {
+      double &block_end = r.block_end[i / TIMELINE_BLOCK];
+      block_end = std::max(block_end, r.intervals[i].end);
+    }
+
+    for(std::size_t b = 0; b < blocks; ++b)
+      r.prefix_end[b] = b > 0 ? std::max(r.prefix_end[b - 1], r.block_end[b]) : r.block_end[b];
+  }
+}
+
+bool timeline::row_range(rectangle const &region, std::size_t &first, std::size_t &last) const
+{
+  double bottom = std::floor(region.bottom() / m_row_height);
+  double top = std::floor(region.top() / m_row_height);
+
+  if(m_rows.empty() || top < 0 || bottom >= m_rows.size())
+    return false;
+
+  first = static_cast<std::size_t>(std::max(bottom, 0.0));
+  last = static_cast<std::size_t>(std::min<double>(top, m_rows.size() - 1));
+
+  return true;
+}
+
+void timeline::draw(renderer *g)
+{
+  if(m_dirty)
+    build();
+
+  g->set_coordinate_system(WORLD);
+
+  rectangle world = g->get_visible_world();
+  double columns = std::max(1.0, std::round(g->get_visible_screen().width()));
+  double width = world.width() / columns;
+
+  std::size_t first_row, last_row;
+  if(!(width > 0) || !row_range(world, first_row, last_row))
+    return;
+
+  // The pixel column of an x coordinate, kept within a column of the view so distant ends do not overflow
+  auto column_of = [&](double x) {
+    return static_cast<long long>(std::min(std::max(std::floor((x - world.left()) / width), -1.0), columns + 1));
+  };
+
+  m_runs.clear();
+  m_run_colors.clear();
+
+  for(std::size_t r = first_row; r <= last_row; ++r) {
+    double bottom = r * m_row_height;
+    double top = bottom + m_row_height * m_row_fill;
+
+    // The run being extended, in pixel columns [run_first, run_last)
+    bool open = false;
+    long long run_first = 0;
+    long long run_last = 0;
+    packed_color run_color;
+
+    auto finish_run = [&]() {
+      if(!open)
+        return;
+
+      m_runs.push_back({{world.left() + run_first * width, bottom}, {world.left() + run_last * width, top}});
+      m_run_colors.push_back(run_color);
+    };
+
+    visit_row(m_rows[r], world.left(), world.right(), [&](timeline_interval const &i) {
+      // Every interval covers at least one pixel
+      long long first = column_of(i.start);
+      long long last = std::max(first + 1, column_of(i.end) + 1);
+
+      // Intervals of the same color that overlap or touch the run extend it
+      if(open && first <= run_last && i.color == run_color) {
+        run_last = std::max(run_last, last);
+        return;
+      }
+
+      if(open && first < run_last) {
+        // Only the part beyond the pixels already drawn is visible
+        if(last <= run_last)
+          return;
+
+        first = run_last;
+      }
+
+      finish_run();
+
+      open = true;
+      run_first = first;
+      run_last = last;
+      run_color = i.color;
+    });
+
+    finish_run();
+  }
+
+  g->fill_rectangles(m_runs, m_run_colors);
+}
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+/**
+ * @file
+ *
+ * Tests the tick steps of axes, and that the axes can be drawn anywhere in the world.
+ */
+
+#include <cstdio>
+
+#include "ezgl/axes.hpp"
+#include "ezgl/camera.hpp"
+#include "ezgl/graphics.hpp"
+
+static int failures = 0;
+
+// Report a failed check and carry on, so that one run shows every failure
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool ok, char const *text, int line)
+{
+  if(!ok) {
+    std::fprintf(stderr, "axes_test.cpp:%d: check failed: %s\n", line, text);
+    ++failures;
+  }
+}
+
+// Cameras are made by canvases; this one shows a world on a screen of a given size, without a widget
+class test_camera : public ezgl::camera {
+public:
+  test_camera(ezgl::rectangle world, int width, int height) : camera(world)
+  {
+    update_widget(width, height);
+  }
+};
+
+// Renderers are also made by canvases; this one draws on a cairo context with the transform of a camera
+class test_renderer : public ezgl::renderer {
+public:
+  test_renderer(cairo_t *context, cairo_surface_t *surface, ezgl::camera *cam)
+      : renderer(context, [cam](ezgl::point2d p) { return cam->world_to_screen(p); }, cam, surface, false)
+  {
+  }
+};
+
+static void test_tick_step()
+{
+  CHECK(ezgl::axes::tick_step(100, 10) == 10);
+  CHECK(ezgl::axes::tick_step(100, 5) == 20);
+  CHECK(ezgl::axes::tick_step(100, 30) == 5);
+
+  // Far from the origin the width of a view is rounded, but the step is still at most that width over the ticks
+  double const offset = 1e18;
+  double const width = (offset + 100) - offset;
+  double const step = ezgl::axes::tick_step(width, 5);
+  CHECK(step > 0 && step <= width / 5 * 2);
+  CHECK(ezgl::axes::tick_step(0, 5) == 1);
+}
+
+// Far from the origin, a tick number plus one is the same number; drawing must still return
+static void test_draw_far_from_origin()
+{
+  int const width = 400;
+  int const height = 300;
+  cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  cairo_t *context = cairo_create(surface);
+
+  ezgl::axes axes;
+  for(double offset : {0.0, 1e9, 1e18, -1e18}) {
+    test_camera cam({{offset, offset}, {offset + 100, offset + 75}}, width, height);
+    test_renderer g(context, surface, &cam);
+    axes.draw(&g);
+  }
+
+  CHECK(cairo_status(context) == CAIRO_STATUS_SUCCESS);
+
+  cairo_destroy(context);
+  cairo_surface_destroy(surface);
+}
+
+int main()
+{
+  test_tick_step();
+  test_draw_far_from_origin();
+
+  if(failures > 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2019-2022 University of Toronto
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Authors: Mario Badr, Sameh Attia, Tanner Young-Schultz and Vaughn Betz
+ */
+
+/**
+ * @file
+ *
+ * Tests that scene files are loaded, paged and streamed correctly, and that corrupt files are rejected.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "ezgl/scene.hpp"
+
+static int failures = 0;
+
+// Report a failed check and carry on, so that one run shows every failure
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool ok, char const *text, int line)
+{
+  if(!ok) {
+    std::fprintf(stderr, "scene_test.cpp:%d: check failed: %s\n", line, text);
+    ++failures;
+  }
+}
+
+static std::vector<unsigned char> read_file(char const *file_path)
+{
+  std::vector<unsigned char> data;
+
+  std::FILE *file = std::fopen(file_path, "rb");
+  if(file == nullptr)
+    return data;
+
+  unsigned char buffer[4096];
+  std::size_t count;
+  while((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    data.insert(data.end(), buffer, buffer + count);
+
+  std::fclose(file);
+  return data;
+}
+
+static bool write_file(char const *file_path, std::vector<unsigned char> const &data)
+{
+  std::FILE *file = std::fopen(file_path, "wb");
+  if(file == nullptr)
+    return false;
+
+  bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+// The number of primitives of a scene that intersect a region
+static std::size_t count_in(ezgl::scene &s, ezgl::rectangle const &region)
+{
+  std::size_t count = 0;
+  s.query(region, [&count](ezgl::scene_primitive const &) { ++count; });
+
+  return count;
+}
+
+// Wait until a streamed scene has read every page
+static void finish_stream(ezgl::scene &s)
+{
+  ezgl::rectangle updated;
+  for(int i = 0; i < 10000 && s.is_streaming(); ++i) {
+    s.update_stream(updated);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// Offsets in the file header: magic, version and byte order, then 64-bit offset/count pairs for the styles,
+// primitives, points, nodes and pages
+static std::size_t const PRIMITIVE_OFFSET_OFFSET = 16 + 16;
+static std::size_t const PAGE_COUNT_OFFSET = 16 + 4 * 16 + 8;
+
+// A tree shorter than the page level is a single page; a file without pages is rejected rather than used unchecked
+static void test_files_without_pages()
+{
+  char const *small_path = "scene_test_small.ezs";
+  char const *no_pages_path = "scene_test_no_pages.ezs";
+  ezgl::rectangle const everything = {{-100, -100}, {100, 100}};
+
+  ezgl::scene small;
+  std::uint32_t style = small.add_style(ezgl::RED, 1);
+  for(int i = 0; i < 10; ++i)
+    small.add_fill_rectangle({{i * 2.0, 0}, {i * 2.0 + 1, 1}}, style, i + 1);
+  CHECK(small.save(small_path));
+
+  ezgl::scene loaded;
+  CHECK(loaded.load(small_path));
+  CHECK(count_in(loaded, everything) == 10);
+
+  ezgl::scene paged;
+  CHECK(paged.load_paged(small_path));
+  CHECK(paged.is_paged());
+  CHECK(count_in(paged, everything) == 10);
+
+  ezgl::scene streamed;
+  CHECK(streamed.stream(small_path));
+  finish_stream(streamed);
+  CHECK(count_in(streamed, everything) == 10);
+
+  std::vector<unsigned char> data = read_file(small_path);
+  CHECK(data.size() > PAGE_COUNT_OFFSET + sizeof(std::uint64_t));
+  if(data.size() <= PAGE_COUNT_OFFSET + sizeof(std::uint64_t))
+    return;
+
+  std::uint64_t const no_pages = 0;
+  std::memcpy(data.data() + PAGE_COUNT_OFFSET, &no_pages, sizeof(no_pages));
+  CHECK(write_file(no_pages_path, data));
+
+  ezgl::scene corrupt;
+  CHECK(!corrupt.load(no_pages_path));
+  CHECK(!corrupt.load_paged(no_pages_path));
+  CHECK(!corrupt.stream(no_pages_path));
+  CHECK(corrupt.empty());
+
+  // An empty scene has neither nodes nor pages
+  ezgl::scene empty;
+  CHECK(empty.save(no_pages_path));
+  CHECK(corrupt.load_paged(no_pages_path));
+  CHECK(count_in(corrupt, everything) == 0);
+
+  std::remove(small_path);
+  std::remove(no_pages_path);
+}
+
+// Loading does not read the primitives; a corrupt page is skipped when it is first used, by every kind of scene
+static void test_corrupt_pages()
+{
+  char const *path = "scene_test_pages.ezs";
+  char const *corrupt_path = "scene_test_corrupt.ezs";
+  ezgl::rectangle const everything = {{-10, -10}, {2000, 2000}};
+
+  ezgl::scene s;
+  std::uint32_t style = s.add_style(ezgl::RED, 1);
+  for(int i = 0; i < 20000; ++i) {
+    double x = (i % 200) * 5.0;
+    double y = (i / 200) * 5.0;
+    s.add_fill_rectangle({{x, y}, {x + 2, y + 3}}, style, i + 1);
+  }
+  CHECK(s.save(path));
+
+  std::vector<unsigned char> data = read_file(path);
+  std::uint64_t primitive_offset = 0;
+  if(data.size() >= PRIMITIVE_OFFSET_OFFSET + sizeof(primitive_offset))
+    std::memcpy(&primitive_offset, data.data() + PRIMITIVE_OFFSET_OFFSET, sizeof(primitive_offset));
+
+  // Give the sixth primitive a style that does not exist
+  std::size_t const bad_field =
+      primitive_offset + 5 * sizeof(ezgl::scene_primitive) + offsetof(ezgl::scene_primitive, style);
+  CHECK(primitive_offset > 0 && bad_field + sizeof(std::uint32_t) <= data.size());
+  if(primitive_offset == 0 || bad_field + sizeof(std::uint32_t) > data.size())
+    return;
+
+  std::uint32_t const bad_style = 77;
+  std::memcpy(data.data() + bad_field, &bad_style, sizeof(bad_style));
+  CHECK(write_file(corrupt_path, data));
+
+  auto all_valid = [&](ezgl::scene &scene) {
+    std::size_t count = 0;
+    bool valid = true;
+    scene.query(everything, [&](ezgl::scene_primitive const &p) {
+      valid = valid && p.style == style;
+      ++count;
+    });
+
+    return valid && count > 0 && count < 20000;
+  };
+
+  ezgl::scene loaded;
+  CHECK(loaded.load(corrupt_path));
+  CHECK(all_valid(loaded));
+  CHECK(!loaded.save(corrupt_path));
+  loaded.add_line({0, 0}, {1, 1}, style);
+  CHECK(loaded.size() == 20000);
+
+  ezgl::scene paged;
+  CHECK(paged.load_paged(corrupt_path));
+  CHECK(all_valid(paged));
+
+  ezgl::scene streamed;
+  CHECK(streamed.stream(corrupt_path));
+  finish_stream(streamed);
+  CHECK(!streamed.is_streaming());
+  CHECK(all_valid(streamed));
+
+  // Every page of an intact file is checked once it has been used, after which the file can be edited
+  ezgl::scene intact;
+  CHECK(intact.load(path));
+  CHECK(count_in(intact, everything) == 20000);
+  intact.add_line({0, 0}, {1, 1}, style);
+  CHECK(intact.size() == 20001);
+
+  std::remove(path);
+  std::remove(corrupt_path);
+}
+
+int main()
+{
+  test_files_without_pages();
+  test_corrupt_pages();
+
+  if(failures > 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+
+  return 0;
+}